@@ -1,12 +1,21 @@
 #pragma once
 #include <memory>
+#include <new>
 #include <deque>
 #include <cassert>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <typeinfo>
+#include <tuple>
 #include <Windows.h>
 #include "Logger.h"
 
 
 #include "Entity.h"
+#include "ComponentManager.h"
+#include "Snapshot.h"
 //#include "../dependencies/xcore/src/xcore.h"
 #include "func_traits.h"
 
@@ -30,6 +39,34 @@ namespace Engine
       size_t size_of_struct;
       size_t offset_from_base;
     };
+
+    struct ColumnMemory
+    {
+      const char* componentName;
+      size_t componentSize;
+      // address space set aside, costs nothing until committed
+      size_t reserved;
+      // backed by memory
+      size_t committed;
+      // actually holding components
+      size_t live;
+    };
+
+    /*
+    decides when a column's unused tail is handed back to the OS
+    a column is only trimmed once most of it is unused, and keeps some headroom
+    above what is live so an archetype that shrinks and regrows a little
+    does not keep decommitting and recommitting the same pages
+    */
+    struct TrimPolicy
+    {
+      // fraction of the committed memory that has to be unused before trimming
+      float minUnusedFraction = 0.5f;
+      // fraction of the live memory kept committed on top of it
+      float headroom = 0.25f;
+      // not worth a call into the OS for less than this
+      size_t minTrimBytes = 16 * SingleCommitSize;
+    };
     template <typename T>
     concept has_Validate = requires(T & t)
     {
@@ -40,6 +77,13 @@ namespace Engine
     {
       t.GetLogData();
     };
+    // components holding entity handles implement this so the handles
+    // follow their entities when a world is merged into another
+    template <typename T>
+    concept has_RemapEntities = requires(T & t, const EntityRemap & remap)
+    {
+      t.RemapEntities(remap);
+    };
 
 
     template<typename  COMPONENT>
@@ -82,10 +126,53 @@ namespace Engine
           VirtualAlloc(data + CommitedMemory, SingleCommitSize, MEM_COMMIT, PAGE_READWRITE);
           CommitedMemory += SingleCommitSize;
         }
+        // the slot may hold a destroyed component from an earlier delete
+        // so it has to be constructed before anything assigns into it
+        new (data + endIndex * compSize) COMPONENT;
         return endIndex++;
       }
 
       ChunkIndex DeleteEntity(ChunkIndex index)
+      {
+        if constexpr (Engine::Component::is_trivially_relocatable_v<COMPONENT>)
+        {
+          // destroy the victim and copy the last row's bytes over it
+          // the last row is relocated so it must not be destroyed
+          // a single copy instead of the three moves a swap does
+          auto& comp = GetComponent(index);
+#ifdef _DEBUG
+          // the same checks DeleteEntity_Swap makes
+          if constexpr (has_Validate<COMPONENT>)
+            comp.Validate();
+          if constexpr (has_LogFunc<COMPONENT>)
+          {
+            if (index == endIndex - 1)
+              Logger::GetInstance()->Log(comp.GetLogData());
+          }
+#endif
+          if constexpr (!std::is_trivially_destructible_v<COMPONENT>)
+            comp.~COMPONENT();
+          if (index != --endIndex)
+          {
+#ifdef _DEBUG
+            if constexpr (has_Validate<COMPONENT>)
+              GetComponent(endIndex).Validate();
+#endif
+            std::memcpy(static_cast<void*>(&comp), data + endIndex * compSize, sizeof(COMPONENT));
+#ifdef _DEBUG
+            if constexpr (has_Validate<COMPONENT>)
+              comp.Validate();
+            if constexpr (has_LogFunc<COMPONENT>)
+              Logger::GetInstance()->Log(comp.GetLogData());
+#endif
+          }
+          return endIndex;
+        }
+        else
+          return DeleteEntity_Swap(index);
+      }
+
+      ChunkIndex DeleteEntity_Swap(ChunkIndex index)
       {
         constexpr bool temp = has_Validate<COMPONENT>;
         constexpr bool hasLogging = has_LogFunc<COMPONENT>;
@@ -143,6 +230,48 @@ namespace Engine
       {
         return *(reinterpret_cast<COMPONENT*>(data + entity * compSize));
       }
+
+      const COMPONENT& GetComponent(ChunkIndex entity) const
+      {
+        return *(reinterpret_cast<const COMPONENT*>(data + entity * compSize));
+      }
+
+      // decommits the tail pages the policy allows, returns the number of bytes released
+      size_t Trim(const TrimPolicy& policy)
+      {
+        // AddEntity keeps room for the next component committed
+        size_t used = (endIndex + 1) * compSize;
+        size_t keep = used + static_cast<size_t>(used * policy.headroom);
+        keep = (keep + SingleCommitSize - 1) / SingleCommitSize * SingleCommitSize;
+        if (CommitedMemory <= keep)
+          return 0;
+
+        size_t unused = CommitedMemory - used;
+        size_t release = CommitedMemory - keep;
+        if (unused < CommitedMemory * policy.minUnusedFraction || release < policy.minTrimBytes)
+          return 0;
+
+        VirtualFree(data + keep, release, MEM_DECOMMIT);
+        CommitedMemory = keep;
+        return release;
+      }
+
+      ColumnMemory GetMemory() const
+      {
+        return ColumnMemory{ typeid(COMPONENT).name(), sizeof(COMPONENT), MAX_CHUNK_SIZE, CommitedMemory, endIndex * compSize };
+      }
+
+      // commits enough memory for count more components in one go
+      // instead of a page at a time as AddEntity does
+      void Reserve(size_t count)
+      {
+        size_t needed = (endIndex + count + 1) * compSize;
+        if (needed <= CommitedMemory)
+          return;
+        size_t commit = (needed - CommitedMemory + SingleCommitSize - 1) / SingleCommitSize * SingleCommitSize;
+        VirtualAlloc(data + CommitedMemory, commit, MEM_COMMIT, PAGE_READWRITE);
+        CommitedMemory += commit;
+      }
     };
 
     template<typename Component>
@@ -150,9 +279,12 @@ namespace Engine
     {
       ~Archetype_Intermediate()
       {
-        for (unsigned i = 0; i < chunk.endIndex; ++i)
+        if constexpr (!std::is_trivially_destructible_v<Component>)
         {
-          GetComponent(i).~Component();
+          for (unsigned i = 0; i < chunk.endIndex; ++i)
+          {
+            GetComponent(i).~Component();
+          }
         }
       }
 
@@ -171,11 +303,141 @@ namespace Engine
       {
         return chunk.DeleteEntity(index);
       }
+
+      void SwapRows(ChunkIndex a, ChunkIndex b)
+      {
+        auto& compA = GetComponent(a);
+        auto& compB = GetComponent(b);
+        if constexpr (Engine::Component::is_trivially_relocatable_v<Component>)
+        {
+          alignas(Component) char temp[sizeof(Component)];
+          std::memcpy(temp, static_cast<void*>(&compA), sizeof(Component));
+          std::memcpy(static_cast<void*>(&compA), static_cast<void*>(&compB), sizeof(Component));
+          std::memcpy(static_cast<void*>(&compB), temp, sizeof(Component));
+        }
+        else
+          std::swap(compA, compB);
+      }
+
+      // moves every component of src onto the end of this column, leaving src empty
+      void Append(Archetype_Intermediate& src)
+      {
+        ChunkIndex count = src.chunk.endIndex;
+        chunk.Reserve(count);
+        if constexpr (Engine::Component::is_trivially_relocatable_v<Component>)
+        {
+          std::memcpy(chunk.data + chunk.endIndex * Chunk_Impl<Component>::compSize, src.chunk.data,
+            count * Chunk_Impl<Component>::compSize);
+          chunk.endIndex += count;
+          // the bytes belong to us now so src must not destroy them
+          src.chunk.endIndex = 0;
+        }
+        else
+        {
+          for (ChunkIndex i = 0; i < count; ++i)
+            GetComponent(chunk.AddEntity()) = std::move(src.GetComponent(i));
+        }
+      }
+
+      // trivially copyable columns are written as one block of raw bytes
+      void Serialize(Snapshot::Writer& writer) const
+      {
+        static_assert(Snapshot::is_serializable<Component>,
+          "component is not trivially copyable and has no Serialize/Deserialize");
+        // lets the loader catch a component whose layout changed since the save
+        writer.Write<uint32_t>(static_cast<uint32_t>(Chunk_Impl<Component>::compSize));
+        if constexpr (std::is_trivially_copyable_v<Component>)
+          writer.WriteColumn(chunk.data, chunk.endIndex * Chunk_Impl<Component>::compSize);
+        else
+        {
+          for (ChunkIndex i = 0; i < chunk.endIndex; ++i)
+            chunk.GetComponent(i).Serialize(writer);
+        }
+      }
+
+      // appends count components read from the snapshot
+      bool Deserialize(Snapshot::Reader& reader, ChunkIndex count)
+      {
+        constexpr size_t compSize = Chunk_Impl<Component>::compSize;
+        if (reader.Read<uint32_t>() != compSize)
+          return false;
+
+        if constexpr (std::is_trivially_copyable_v<Component>)
+        {
+          // taken before reserving so a corrupt count cannot commit more pages than the file holds
+          const char* src = reader.Take(size_t(count) * compSize);
+          if (!src)
+            return false;
+          chunk.Reserve(count);
+          std::memcpy(chunk.data + chunk.endIndex * compSize, src, size_t(count) * compSize);
+          chunk.endIndex += count;
+        }
+        else
+        {
+          // rows read at least a byte each in practice, so more than that is not reserved up front
+          chunk.Reserve(std::min<size_t>(count, reader.Remaining()));
+          for (ChunkIndex i = 0; i < count && !reader.Failed(); ++i)
+            chunk.GetComponent(chunk.AddEntity()).Deserialize(reader);
+        }
+        return !reader.Failed();
+      }
+    };
+
+    // shared components have no column, the whole archetype group
+    // shares the one value so every index resolves to it
+    template<typename Component> requires Engine::Component::is_shared_component<Component>
+    struct Archetype_Intermediate<Component>
+    {
+      Component value{};
+
+      Component& GetComponent(ChunkIndex)
+      {
+        return value;
+      }
+
+      ChunkIndex DeleteEntity(ChunkIndex index)
+      {
+        return index;
+      }
+
+      void Serialize(Snapshot::Writer& writer) const
+      {
+        static_assert(Snapshot::is_serializable<Component>,
+          "shared component is not trivially copyable and has no Serialize/Deserialize");
+        Snapshot::WriteValue(writer, value);
+      }
+
+      bool Deserialize(Snapshot::Reader& reader)
+      {
+        Snapshot::ReadValue(reader, value);
+        return !reader.Failed();
+      }
+    };
+
+    // tags have no state at all, so there is nothing to store
+    // the intermediate only exists so the archetype still reports having the tag
+    template<typename Component> requires Engine::Component::is_tag_component<Component>
+    struct Archetype_Intermediate<Component>
+    {
+      static inline Component instance{};
+
+      Component& GetComponent(ChunkIndex)
+      {
+        return instance;
+      }
+
+      ChunkIndex DeleteEntity(ChunkIndex index)
+      {
+        return index;
+      }
     };
 
     struct Archetype
     {
       size_t entityNum = 0;
+      // bumped whenever rows are added, removed or reordered
+      // so anything holding on to row indices can tell they went stale
+      uint64_t version = 0;
       virtual ~Archetype() = default;
       
       template<typename Component, typename = std::enable_if_t<std::negation_v<std::is_pointer<Component>::type>>>
@@ -196,25 +458,138 @@ namespace Engine
         return nullptr;
       }
 
+      // value of a shared component for this whole archetype group
+      // writing to it changes it for every entity in the group
+      // use EntityManager::SetSharedComponent to change it for a single entity
+      template<typename Component>
+      Component& GetSharedComponent()
+      {
+        return dynamic_cast<Archetype_Intermediate<Component>*>(this)->value;
+      }
+
+      // tags taken by reference are always present and stateless
+      // so they are handed over without looking up the archetype
+      template<typename ArgType>
+      decltype(auto) GetArgument(ChunkIndex index)
+      {
+        using Component = std::decay_t<ArgType>;
+        if constexpr (Engine::Component::is_tag_component<Component>)
+          return (Archetype_Intermediate<Component>::instance);
+        else
+          return GetComponent<ArgType>(index);
+      }
+
+      // where one system argument lives in this archetype, looked up once
+      // so reading it for a row is an index instead of a dynamic_cast
+      template<typename ArgType>
+      struct ColumnBinding
+      {
+        using Component = std::remove_pointer_t<std::decay_t<ArgType>>;
+        Archetype_Intermediate<Component>* intermediate = nullptr;
+
+        explicit ColumnBinding(Archetype& archetype)
+        {
+          // tags taken by reference are always there and need no lookup
+          if constexpr (std::is_pointer_v<ArgType> || !Engine::Component::is_tag_component<Component>)
+            intermediate = dynamic_cast<Archetype_Intermediate<Component>*>(&archetype);
+        }
+
+        decltype(auto) Get(ChunkIndex index)
+        {
+          if constexpr (std::is_pointer_v<ArgType>)
+            return intermediate ? &intermediate->GetComponent(index) : static_cast<Component*>(nullptr);
+          else if constexpr (Engine::Component::is_tag_component<Component>)
+            return (Archetype_Intermediate<Component>::instance);
+          else
+            return (intermediate->GetComponent(index));
+        }
+      };
+
+      // every argument of a functor bound to this archetype
+      template<typename... ArgType>
+      struct ArgumentBinding
+      {
+        std::tuple<ColumnBinding<ArgType>...> columns;
+
+        explicit ArgumentBinding(Archetype& archetype) :
+          columns{ ColumnBinding<ArgType>(archetype)... }
+        {
+        }
+
+        template<typename Functor>
+        void Call(Functor& func, ChunkIndex index)
+        {
+          std::apply([&](auto&... column) { func(column.Get(index)...); }, columns);
+        }
+      };
+
+      template<typename Functor>
+      auto BindArguments(Functor&)
+      {
+        using func_traits = Engine::traits<Functor>;
+        return[this]<typename... ArgType>(std::tuple<ArgType...>*)
+        {
+          return ArgumentBinding<ArgType...>{ *this };
+        }(static_cast<typename func_traits::args_tuple*>(nullptr));
+      }
+
       template <typename Functor, typename... ArgType>
       void RunWithFunctor(Functor& func, ChunkIndex index, std::tuple<ArgType...>*)
       {
-        func(GetComponent<ArgType>(index)...);
+        func(GetArgument<ArgType>(index)...);
       }
 
       template<typename Functor>
       void RunWithFunctor(Functor& func)
       {
-        // get the type of arguments
-        using func_traits = Engine::traits<Functor>;
+        RunWithFunctors(func);
+      }
 
-        for (int i = 0; i < entityNum; ++i)
+      // runs every functor on a row before moving on to the next row,
+      // so columns the functors have in common go through the cache once
+      template<typename... Functors>
+      void RunWithFunctors(Functors&... funcs)
+      {
+        auto bindings = std::make_tuple(BindArguments(funcs)...);
+        for (ChunkIndex i = 0; i < entityNum; ++i)
         {
-          // getcomponent<arg1> ;
-          RunWithFunctor(func, i, reinterpret_cast<func_traits::args_tuple*>(nullptr));
+          std::apply([&](auto&... binding) { (binding.Call(funcs, i), ...); }, bindings);
         }
       }
       virtual ChunkIndex DeleteEntity(ChunkIndex index) = 0;
+
+      // new archetype of the same type with the same shared values and no entities
+      virtual std::shared_ptr<Archetype> CloneEmpty() const = 0;
+      // true if rhs is the same type and all shared values compare equal
+      virtual bool SharedEquals(const Archetype& rhs) const = 0;
+      // takes on src's shared values, src has to be the same type and this has to be empty
+      virtual void CopySharedFrom(const Archetype& src) = 0;
+      // moves the row at index into dst which has to be the same type
+      // the row here is left for DeleteEntity to clean up
+      // returns the index in dst
+      virtual ChunkIndex MoveEntityTo(ChunkIndex index, Archetype& dst) = 0;
+
+      // component ids in template order, which is the order the columns are saved in
+      virtual std::vector<unsigned> GetComponentOrder() const = 0;
+      // writes the shared values followed by every column
+      virtual void Serialize(Snapshot::Writer& writer) const = 0;
+      // reads shared values and appends the rows written by Serialize
+      // returns false if the data does not match this archetype
+      virtual bool Deserialize(Snapshot::Reader& reader) = 0;
+
+      // swaps two rows across every column, EntityDB has to be fixed up by the caller
+      virtual void SwapRows(ChunkIndex a, ChunkIndex b) = 0;
+
+      // appends the memory used by each column
+      virtual void GetMemory(std::vector<ColumnMemory>& columns) const = 0;
+      // returns the number of bytes decommitted
+      virtual size_t Trim(const TrimPolicy& policy) = 0;
+
+      // moves every row of src, which has to be the same type, onto the end of this archetype
+      // returns the index of the first appended row
+      virtual ChunkIndex AppendFrom(Archetype& src) = 0;
+      // runs RemapEntities on every component in rows [begin, end) that has it
+      virtual void RemapEntities(ChunkIndex begin, ChunkIndex end, const EntityRemap& remap) = 0;
     };
 
     template<typename... COMPONENTS>
@@ -225,8 +600,12 @@ namespace Engine
       template<size_t I, typename Component, typename... Component_other>
       ChunkIndex AddEntity_helper(ChunkIndex expectedIndex)
       {
-        auto temp = dynamic_cast<Archetype_Intermediate<Component>*>(this)->AddEntity_helper();
-        assert(temp == expectedIndex);
+        // shared components and tags have nothing to add per entity
+        if constexpr (Engine::Component::has_column_storage<Component>)
+        {
+          [[maybe_unused]] auto temp = dynamic_cast<Archetype_Intermediate<Component>*>(this)->AddEntity_helper();
+          assert(temp == expectedIndex);
+        }
 
         if constexpr(sizeof...(Component_other) > 0)
           AddEntity_helper<I + 1, Component_other...>(expectedIndex);
@@ -241,6 +620,118 @@ namespace Engine
         return 0;
       }
 
+      template<typename Component>
+      void CopyShared(Archetype_Impl& dst) const
+      {
+        if constexpr (Engine::Component::is_shared_component<Component>)
+          static_cast<Archetype_Intermediate<Component>&>(dst).value =
+            static_cast<const Archetype_Intermediate<Component>&>(*this).value;
+      }
+
+      template<typename Component>
+      bool SharedEquals(const Archetype_Impl& rhs) const
+      {
+        if constexpr (Engine::Component::is_shared_component<Component>)
+          return static_cast<const Archetype_Intermediate<Component>&>(*this).value ==
+            static_cast<const Archetype_Intermediate<Component>&>(rhs).value;
+        else
+          return true;
+      }
+
+      template<typename Component>
+      void MoveComponent(Archetype_Impl& dst, ChunkIndex from, ChunkIndex to)
+      {
+        if constexpr (Engine::Component::has_column_storage<Component>)
+        {
+          auto& dstComp = static_cast<Archetype_Intermediate<Component>&>(dst).GetComponent(to);
+          auto& srcComp = static_cast<Archetype_Intermediate<Component>&>(*this).GetComponent(from);
+          if constexpr (Engine::Component::is_trivially_relocatable_v<Component>)
+          {
+            dstComp.~Component();
+            std::memcpy(static_cast<void*>(&dstComp), &srcComp, sizeof(Component));
+            // the bytes now belong to dst, give the source slot a fresh object
+            // so the DeleteEntity that follows has something valid to destroy
+            if constexpr (!std::is_trivially_destructible_v<Component>)
+              new (&srcComp) Component;
+          }
+          else
+            dstComp = std::move(srcComp);
+        }
+      }
+
+      template<typename Component>
+      void SerializeShared(Snapshot::Writer& writer) const
+      {
+        if constexpr (Engine::Component::is_shared_component<Component>)
+          static_cast<const Archetype_Intermediate<Component>&>(*this).Serialize(writer);
+      }
+
+      template<typename Component>
+      void SerializeColumn(Snapshot::Writer& writer) const
+      {
+        if constexpr (Engine::Component::has_column_storage<Component>)
+          static_cast<const Archetype_Intermediate<Component>&>(*this).Serialize(writer);
+      }
+
+      template<typename Component>
+      bool DeserializeShared(Snapshot::Reader& reader)
+      {
+        if constexpr (Engine::Component::is_shared_component<Component>)
+          return static_cast<Archetype_Intermediate<Component>&>(*this).Deserialize(reader);
+        else
+          return true;
+      }
+
+      template<typename Component>
+      bool DeserializeColumn(Snapshot::Reader& reader, ChunkIndex count)
+      {
+        if constexpr (Engine::Component::has_column_storage<Component>)
+          return static_cast<Archetype_Intermediate<Component>&>(*this).Deserialize(reader, count);
+        else
+          return true;
+      }
+
+      template<typename Component>
+      void AppendColumn(Archetype_Impl& src)
+      {
+        if constexpr (Engine::Component::has_column_storage<Component>)
+          static_cast<Archetype_Intermediate<Component>&>(*this).Append(static_cast<Archetype_Intermediate<Component>&>(src));
+      }
+
+      template<typename Component>
+      void SwapColumnRows(ChunkIndex a, ChunkIndex b)
+      {
+        if constexpr (Engine::Component::has_column_storage<Component>)
+          static_cast<Archetype_Intermediate<Component>&>(*this).SwapRows(a, b);
+      }
+
+      template<typename Component>
+      void GetColumnMemory(std::vector<ColumnMemory>& columns) const
+      {
+        if constexpr (Engine::Component::has_column_storage<Component>)
+          columns.push_back(static_cast<const Archetype_Intermediate<Component>&>(*this).chunk.GetMemory());
+      }
+
+      template<typename Component>
+      size_t TrimColumn(const TrimPolicy& policy)
+      {
+        if constexpr (Engine::Component::has_column_storage<Component>)
+          return static_cast<Archetype_Intermediate<Component>&>(*this).chunk.Trim(policy);
+        else
+          return 0;
+      }
+
+      template<typename Component>
+      void RemapColumn(ChunkIndex begin, ChunkIndex end, const EntityRemap& remap)
+      {
+        if constexpr (Engine::Component::has_column_storage<Component> && has_RemapEntities<Component>)
+        {
+          auto& column = static_cast<Archetype_Intermediate<Component>&>(*this);
+          for (ChunkIndex i = begin; i < end; ++i)
+            column.GetComponent(i).RemapEntities(remap);
+        }
+      }
+
       // start
       template<size_t I, typename Component, typename... Component_other>
       ChunkIndex AddEntity_helper()
@@ -251,6 +742,7 @@ namespace Engine
           AddEntity_helper<I + 1, Component_other...>(temp);
         }
         ++entityNum;
+        ++version;
         return temp;
       }
 
@@ -262,10 +754,14 @@ namespace Engine
         ChunkIndex idx = index;
         if constexpr (sizeof...(COMPONENTS) > 0)
         {
-          idx = (dynamic_cast<Archetype_Intermediate<EntityComponent>*>(this)->DeleteEntity(index));
-          (dynamic_cast<Archetype_Intermediate<COMPONENTS>*>(this)->DeleteEntity(index),...);
+          // the bases are known here so no need to go through dynamic_cast for every column,
+          // each column is its own reservation so there is nothing to batch across them,
+          // the calls are resolved statically and inline into this one function
+          idx = static_cast<Archetype_Intermediate<EntityComponent>&>(*this).DeleteEntity(index);
+          (static_cast<Archetype_Intermediate<COMPONENTS>&>(*this).DeleteEntity(index), ...);
         }
         --entityNum;
+        ++version;
         return idx;
       }
 
@@ -273,6 +769,120 @@ namespace Engine
       {
       }
 
+      virtual std::shared_ptr<Archetype> CloneEmpty() const override
+      {
+        auto clone = std::make_shared<Archetype_Impl>();
+        (CopyShared<COMPONENTS>(*clone), ...);
+        return clone;
+      }
+
+      virtual bool SharedEquals(const Archetype& rhs) const override
+      {
+        auto other = dynamic_cast<const Archetype_Impl*>(&rhs);
+        if (!other)
+          return false;
+        return (SharedEquals<COMPONENTS>(*other) && ...);
+      }
+
+      virtual void CopySharedFrom(const Archetype& src) override
+      {
+        assert(!entityNum);
+        auto& other = dynamic_cast<const Archetype_Impl&>(src);
+        (other.template CopyShared<COMPONENTS>(*this), ...);
+      }
+
+      virtual ChunkIndex MoveEntityTo(ChunkIndex index, Archetype& dst) override
+      {
+        auto& other = dynamic_cast<Archetype_Impl&>(dst);
+        ChunkIndex newIndex = other.AddEntity();
+        MoveComponent<EntityComponent>(other, index, newIndex);
+        (MoveComponent<COMPONENTS>(other, index, newIndex), ...);
+        return newIndex;
+      }
+
+      virtual std::vector<unsigned> GetComponentOrder() const override
+      {
+        return { Engine::Component::component_id_v<COMPONENTS>... };
+      }
+
+      virtual void Serialize(Snapshot::Writer& writer) const override
+      {
+        (SerializeShared<COMPONENTS>(writer), ...);
+        writer.Write<uint64_t>(entityNum);
+        if constexpr (sizeof...(COMPONENTS) > 0)
+        {
+          SerializeColumn<EntityComponent>(writer);
+          (SerializeColumn<COMPONENTS>(writer), ...);
+        }
+      }
+
+      virtual bool Deserialize(Snapshot::Reader& reader) override
+      {
+        if (!(DeserializeShared<COMPONENTS>(reader) && ...))
+          return false;
+        auto rows = reader.Read<uint64_t>();
+        if (reader.Failed() || rows > (std::numeric_limits<ChunkIndex>::max)())
+          return false;
+        auto count = static_cast<ChunkIndex>(rows);
+        if constexpr (sizeof...(COMPONENTS) > 0)
+        {
+          if (!DeserializeColumn<EntityComponent>(reader, count) ||
+            !(DeserializeColumn<COMPONENTS>(reader, count) && ...))
+            return false;
+          entityNum += count;
+          ++version;
+        }
+        return true;
+      }
+
+      virtual ChunkIndex AppendFrom(Archetype& src) override
+      {
+        auto& other = dynamic_cast<Archetype_Impl&>(src);
+        auto first = static_cast<ChunkIndex>(entityNum);
+        if constexpr (sizeof...(COMPONENTS) > 0)
+        {
+          AppendColumn<EntityComponent>(other);
+          (AppendColumn<COMPONENTS>(other), ...);
+          entityNum += other.entityNum;
+          other.entityNum = 0;
+          ++version;
+          ++other.version;
+        }
+        return first;
+      }
+
+      virtual void SwapRows(ChunkIndex a, ChunkIndex b) override
+      {
+        if constexpr (sizeof...(COMPONENTS) > 0)
+        {
+          SwapColumnRows<EntityComponent>(a, b);
+          (SwapColumnRows<COMPONENTS>(a, b), ...);
+        }
+        ++version;
+      }
+
+      virtual void GetMemory(std::vector<ColumnMemory>& columns) const override
+      {
+        if constexpr (sizeof...(COMPONENTS) > 0)
+        {
+          GetColumnMemory<EntityComponent>(columns);
+          (GetColumnMemory<COMPONENTS>(columns), ...);
+        }
+      }
+
+      virtual size_t Trim(const TrimPolicy& policy) override
+      {
+        if constexpr (sizeof...(COMPONENTS) > 0)
+          return TrimColumn<EntityComponent>(policy) + (0 + ... + TrimColumn<COMPONENTS>(policy));
+        else
+          return 0;
+      }
+
+      virtual void RemapEntities(ChunkIndex begin, ChunkIndex end, const EntityRemap& remap) override
+      {
+        (RemapColumn<COMPONENTS>(begin, end, remap), ...);
+      }
+
       size_t firstEmptyChunk = 0;
 
       ChunkIndex AddEntity()
@@ -0,0 +1,239 @@
+#include "AsyncSnapshot.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+
+using namespace Engine::Snapshot;
+
+namespace
+{
+	// granularity VirtualProtect works at
+	constexpr size_t PageSize = 1ull << 12;
+
+	size_t PageCount(size_t bytes)
+	{
+		return (bytes + PageSize - 1) / PageSize;
+	}
+
+	// every snapshot that currently has frozen pages
+	std::mutex s_activeLock;
+	std::vector<AsyncSnapshot*> s_active;
+	PVOID s_handler = nullptr;
+
+	LONG CALLBACK OnAccessViolation(EXCEPTION_POINTERS* info)
+	{
+		auto* record = info->ExceptionRecord;
+		// ExceptionInformation[0] is 1 for a write, [1] is the address written to
+		if (record->ExceptionCode != EXCEPTION_ACCESS_VIOLATION || record->ExceptionInformation[0] != 1)
+			return EXCEPTION_CONTINUE_SEARCH;
+
+		if (AsyncSnapshot::HandleWriteFault(reinterpret_cast<const char*>(record->ExceptionInformation[1])))
+			return EXCEPTION_CONTINUE_EXECUTION;
+		return EXCEPTION_CONTINUE_SEARCH;
+	}
+}
+
+AsyncSnapshot::AsyncSnapshot(const std::string& path) :
+	m_path{ path }
+{
+}
+
+AsyncSnapshot::~AsyncSnapshot()
+{
+	Wait();
+	if (m_pageCopies)
+		VirtualFree(m_pageCopies, 0, MEM_RELEASE);
+}
+
+void AsyncSnapshot::Write(const void* data, size_t size)
+{
+	assert(!m_started);
+	if (m_segments.empty() || m_segments.back().column)
+		m_segments.emplace_back();
+	auto& bytes = m_segments.back().bytes;
+	bytes.insert(bytes.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+}
+
+void AsyncSnapshot::WriteColumn(const void* data, size_t size)
+{
+	assert(!m_started);
+	if (size == 0)
+		return;
+	// columns start at the beginning of their own reservation
+	assert(reinterpret_cast<uintptr_t>(data) % PageSize == 0);
+
+	Segment segment;
+	segment.column = static_cast<const char*>(data);
+	segment.columnSize = size;
+	segment.firstPage = m_pageStates.size();
+	m_segments.push_back(std::move(segment));
+	m_pageStates.resize(m_pageStates.size() + PageCount(size), PageState::Frozen);
+}
+
+bool AsyncSnapshot::Good() const
+{
+	return !m_failed && (!m_done || m_success);
+}
+
+void AsyncSnapshot::KeepAlive(std::shared_ptr<void> object)
+{
+	m_keepAlive.push_back(std::move(object));
+}
+
+void AsyncSnapshot::Start()
+{
+	assert(!m_started);
+	m_started = true;
+	if (!m_pageStates.empty())
+	{
+		// committed up front, only the pages that are actually copied ever get touched
+		m_pageCopies = static_cast<char*>(VirtualAlloc(nullptr, m_pageStates.size() * PageSize,
+			MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+		if (!m_pageCopies)
+			m_failed = true;
+	}
+
+	// the handler has to be in place before anything becomes read only
+	Register(this);
+	for (auto& segment : m_segments)
+	{
+		// without somewhere to copy pages to nothing can be frozen, the columns are written as they are
+		if (!segment.column || !m_pageCopies)
+			continue;
+		DWORD old;
+		if (!VirtualProtect(const_cast<char*>(segment.column), PageCount(segment.columnSize) * PageSize, PAGE_READONLY, &old))
+			m_failed = true;
+	}
+
+	m_thread = std::thread{ &AsyncSnapshot::WriteToFile, this };
+}
+
+bool AsyncSnapshot::IsDone() const
+{
+	return m_done;
+}
+
+bool AsyncSnapshot::Wait()
+{
+	if (m_thread.joinable())
+		m_thread.join();
+	// released here so the archetypes are never destroyed on the background thread
+	m_keepAlive.clear();
+	return m_success && !m_failed;
+}
+
+bool AsyncSnapshot::CopyOnWrite(const char* address)
+{
+	// nothing was frozen
+	if (!m_pageCopies)
+		return false;
+
+	for (auto& segment : m_segments)
+	{
+		if (!segment.column || address < segment.column ||
+			address >= segment.column + PageCount(segment.columnSize) * PageSize)
+			continue;
+
+		size_t page = (address - segment.column) / PageSize;
+		char* pageStart = const_cast<char*>(segment.column) + page * PageSize;
+
+		std::lock_guard lock{ m_pageLock };
+		auto& state = m_pageStates[segment.firstPage + page];
+		if (state == PageState::Frozen)
+		{
+			std::memcpy(m_pageCopies + (segment.firstPage + page) * PageSize, pageStart, PageSize);
+			state = PageState::Copied;
+		}
+		// the background thread may have got here first, asking again is harmless
+		// if the page cannot be made writable the write would only fault again, so it is not handled
+		DWORD old;
+		if (!VirtualProtect(pageStart, PageSize, PAGE_READWRITE, &old))
+		{
+			m_failed = true;
+			return false;
+		}
+		return true;
+	}
+	return false;
+}
+
+void AsyncSnapshot::WriteToFile()
+{
+	std::ofstream fs(m_path, std::ios::binary | std::ios::trunc);
+	auto buffer = std::make_unique<char[]>(PageSize);
+
+	// every page has to be released even if the file could not be opened
+	for (auto& segment : m_segments)
+	{
+		if (!segment.column)
+		{
+			fs.write(segment.bytes.data(), segment.bytes.size());
+			continue;
+		}
+
+		for (size_t page = 0; page < PageCount(segment.columnSize); ++page)
+		{
+			char* pageStart = const_cast<char*>(segment.column) + page * PageSize;
+			size_t size = std::min(PageSize, segment.columnSize - page * PageSize);
+			size_t index = segment.firstPage + page;
+
+			const char* source = buffer.get();
+			{
+				std::lock_guard lock{ m_pageLock };
+				if (m_pageStates[index] == PageState::Copied)
+				{
+					source = m_pageCopies + index * PageSize;
+				}
+				else
+				{
+					// still frozen so nobody has written to it, take it as is and let writes through
+					std::memcpy(buffer.get(), pageStart, size);
+					DWORD old;
+					if (m_pageCopies && !VirtualProtect(pageStart, PageSize, PAGE_READWRITE, &old))
+						m_failed = true;
+				}
+				m_pageStates[index] = PageState::Released;
+			}
+			// copies are never written again once released, so they can be read outside the lock
+			fs.write(source, size);
+		}
+	}
+
+	// closing flushes what is still buffered, so that can fail too
+	fs.close();
+	m_success = !fs.fail();
+
+	Unregister(this);
+	m_done = true;
+}
+
+bool AsyncSnapshot::HandleWriteFault(const char* address)
+{
+	std::lock_guard lock{ s_activeLock };
+	for (auto* snapshot : s_active)
+	{
+		if (snapshot->CopyOnWrite(address))
+			return true;
+	}
+	return false;
+}
+
+void AsyncSnapshot::Register(AsyncSnapshot* snapshot)
+{
+	std::lock_guard lock{ s_activeLock };
+	if (s_active.empty())
+		s_handler = AddVectoredExceptionHandler(1, OnAccessViolation);
+	s_active.push_back(snapshot);
+}
+
+void AsyncSnapshot::Unregister(AsyncSnapshot* snapshot)
+{
+	std::lock_guard lock{ s_activeLock };
+	s_active.erase(std::remove(s_active.begin(), s_active.end(), snapshot), s_active.end());
+	if (s_active.empty() && s_handler)
+	{
+		RemoveVectoredExceptionHandler(s_handler);
+		s_handler = nullptr;
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "Snapshot.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Engine
+{
+	namespace Snapshot
+	{
+		/*
+		writes a snapshot on a background thread while the simulation keeps running
+		everything small (entity table, shared values, columns with hooks) is copied
+		into the snapshot straight away, columns of raw component data are frozen instead:
+		their pages are made read only and the first write to a page faults, the fault
+		handler copies the page aside and gives write access back so the main thread
+		only ever pays for the pages it actually touches
+		the background thread claims pages one at a time, taking the copy if there is one
+		and unfreezing the page itself if there is not
+		the copies go into a pool committed by Start, one slot per frozen page, so the
+		fault handler never calls into the heap the faulting thread may be in the middle of
+		*/
+		class AsyncSnapshot : public Writer
+		{
+			enum class PageState : uint8_t
+			{
+				Frozen,
+				// the fault handler made a copy, live memory has moved on
+				Copied,
+				// the background thread is done with it
+				Released
+			};
+
+			struct Segment
+			{
+				// bytes copied at capture time
+				std::vector<char> bytes;
+				// or a frozen column
+				const char* column = nullptr;
+				size_t columnSize = 0;
+				// index of the column's first page in m_pageStates
+				size_t firstPage = 0;
+			};
+
+			std::string m_path;
+			std::vector<Segment> m_segments;
+
+			std::mutex m_pageLock;
+			std::vector<PageState> m_pageStates;
+			// PageSize bytes for every entry in m_pageStates, at the same index
+			char* m_pageCopies = nullptr;
+
+			// things that have to outlive the background thread, like the archetypes owning the columns
+			std::vector<std::shared_ptr<void>> m_keepAlive;
+
+			std::thread m_thread;
+			std::atomic<bool> m_done = false;
+			// set by whichever thread sees a page protection or the file fail
+			std::atomic<bool> m_failed = false;
+			bool m_success = false;
+			bool m_started = false;
+
+			// returns true if address is in one of our frozen pages and it is now writable
+			bool CopyOnWrite(const char* address);
+			void WriteToFile();
+
+			static void Register(AsyncSnapshot* snapshot);
+			static void Unregister(AsyncSnapshot* snapshot);
+
+		public:
+			explicit AsyncSnapshot(const std::string& path);
+			// waits for the background thread
+			~AsyncSnapshot();
+
+			AsyncSnapshot(const AsyncSnapshot&) = delete;
+			AsyncSnapshot& operator=(const AsyncSnapshot&) = delete;
+
+			using Writer::Write;
+			virtual void Write(const void* data, size_t size) override;
+			virtual void WriteColumn(const void* data, size_t size) override;
+			// false once freezing a page, letting writes through or writing the file has failed
+			virtual bool Good() const override;
+
+			void KeepAlive(std::shared_ptr<void> object);
+
+			// freezes the captured columns and hands them to the background thread
+			// nothing may be written to the snapshot after this
+			void Start();
+
+			bool IsDone() const;
+			// blocks until the file is written, returns whether it succeeded
+			bool Wait();
+
+			// called by the access violation handler, not meant to be called directly
+			static bool HandleWriteFault(const char* address);
+		};
+	}
+}
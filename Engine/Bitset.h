@@ -1,5 +1,6 @@
 #pragma once
 #include <type_traits>
+#include <cstdint>
 
 namespace Engine
 {
@@ -13,20 +14,20 @@ namespace Engine
 			const Underlying size = multiplier;
 			Underlying data[multiplier];
 
-			Bitset()
+			constexpr Bitset()
 			{
 				for (auto& d : data)
 					d = 0;
 			}
 
-			Bitset(uint32_t offset)
+			constexpr Bitset(uint32_t offset)
 			{
 				for (auto& d : data)
 					d = 0;
 				Set(offset);
 			}
 
-			Bitset(const Bitset& rhs)
+			constexpr Bitset(const Bitset& rhs)
 			{
 				int i = 0;
 				for (auto& d : data)
@@ -40,19 +41,27 @@ namespace Engine
 				return data;
 			}
 
+			static constexpr unsigned BitsPerUnderlying = sizeof(Underlying) * 8;
+			static constexpr unsigned Length = multiplier * BitsPerUnderlying;
+
 			constexpr unsigned GetLength() const
 			{
-				return multiplier * Underlying;
+				return multiplier * BitsPerUnderlying;
 			}
 
-			void Set(unsigned index)
+			constexpr void Set(unsigned index)
 			{
-				data[index / sizeof(Underlying)] |= 1ull << (index % sizeof(Underlying));
+				data[index / BitsPerUnderlying] |= Underlying{ 1 } << (index % BitsPerUnderlying);
 			}
 
-			void Reset(unsigned index)
+			constexpr void Reset(unsigned index)
 			{
-				data[index / sizeof(Underlying)] ^= 1ull << (index % sizeof(Underlying));
+				data[index / BitsPerUnderlying] &= ~(Underlying{ 1 } << (index % BitsPerUnderlying));
+			}
+
+			constexpr bool Test(unsigned index) const
+			{
+				return data[index / BitsPerUnderlying] & (Underlying{ 1 } << (index % BitsPerUnderlying));
 			}
 
 			void Invert(unsigned index)
@@ -61,7 +70,7 @@ namespace Engine
 			}
 
 			// exact copy
-			bool operator==(const Bitset<multiplier, Underlying>& rhs) const
+			constexpr bool operator==(const Bitset<multiplier, Underlying>& rhs) const
 			{
 				int i = 0;
 				for (auto& d : data)
@@ -73,12 +82,12 @@ namespace Engine
 			}
 
 			// not exact copy
-			bool operator!=(const Bitset<multiplier, Underlying>& rhs) const
+			constexpr bool operator!=(const Bitset<multiplier, Underlying>& rhs) const
 			{
 				return !(*this == rhs);
 			}
 
-			Bitset<multiplier, Underlying>& operator+=(const Bitset<multiplier, Underlying>& rhs)
+			constexpr Bitset<multiplier, Underlying>& operator+=(const Bitset<multiplier, Underlying>& rhs)
 			{
 				int i = 0;
 				for (auto& d : data)
@@ -100,17 +109,17 @@ namespace Engine
 			}
 
 
-			Bitset<multiplier, Underlying>& operator=(const Bitset<multiplier, Underlying>& rhs)
+			constexpr Bitset<multiplier, Underlying>& operator=(const Bitset<multiplier, Underlying>& rhs)
 			{
 				int i = 0;
 				for (auto& d : data)
 				{
 					d = rhs.data[i++];
 				}
-				return this;
+				return *this;
 			}
 
-			operator bool () const
+			constexpr operator bool () const
 			{
 				for (auto& d : data)
 				{
@@ -122,11 +131,11 @@ namespace Engine
 		};
 
 		template <unsigned multiplier, typename Underlying>
-		Bitset<multiplier, Underlying> operator+(const Bitset<multiplier, Underlying>& lhs, const Bitset<multiplier, Underlying>& rhs)
+		constexpr Bitset<multiplier, Underlying> operator+(const Bitset<multiplier, Underlying>& lhs, const Bitset<multiplier, Underlying>& rhs)
 		{
 			Bitset other{ lhs };
 			other += rhs;
-			return std::move(other);
+			return other;
 		}
 	}
 }
\ No newline at end of file
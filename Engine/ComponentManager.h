@@ -1,58 +1,128 @@
 #pragma once
+#include <cstddef>
 #include <type_traits>
 #include "Bitset.h"
+#include "Entity.h"
 
 namespace Engine
 {
 	namespace Component
 	{
 
-		using ComponentBitset = Tools::Bitset<2>;
+		// 128 component types, tags included
+		using ComponentBitset = Tools::Bitset<2, uint64_t>;
+
+		// the components an application uses, in a fixed order
+		// a component's bit in archetype signatures and queries is 1 + its place in the list,
+		// bit 0 is always EntityComponent which does not need to be listed
+		template <typename... COMPONENTS>
+		struct ComponentList
+		{
+			static constexpr size_t size = sizeof...(COMPONENTS);
+		};
+
+		// the application's list, filled in with ENGINE_COMPONENTS
+		// the parameter is only there to keep lookups dependent until the list has been declared
+		template <typename = void>
+		struct application_components
+		{
+			using type = ComponentList<>;
+		};
+
 		namespace Details
 		{
-			struct info
+			template <typename T, typename... LIST>
+			constexpr size_t count_v = (size_t{ 0 } + ... + std::is_same_v<T, LIST>);
+
+			template <typename T, typename... COMPONENTS>
+			constexpr int IndexOf(ComponentList<COMPONENTS...>*)
 			{
-				mutable int m_UID;
-				size_t m_size;
-			};
+				// leading false so an empty list still makes an array
+				constexpr bool matches[] = { false, std::is_same_v<T, COMPONENTS>... };
+				for (int i = 1; i < static_cast<int>(sizeof(matches)); ++i)
+				{
+					if (matches[i])
+						return i - 1;
+				}
+				return -1;
+			}
 
 			template <typename T>
-			constexpr info CreateInfo()
+			constexpr unsigned ComponentID()
 			{
-				return info
+				if constexpr (std::is_same_v<T, EntityComponent>)
+					return 0;
+				else
 				{
-					-1,
-					sizeof(T)
-				};
+					using list = typename application_components<std::void_t<T>>::type;
+					constexpr int index = IndexOf<T>(static_cast<list*>(nullptr));
+					static_assert(index >= 0, "component is missing from ENGINE_COMPONENTS");
+					static_assert(index + 1 < ComponentBitset::Length, "too many components for ComponentBitset");
+					return index + 1;
+				}
+			}
+
+			template <typename... COMPONENTS>
+			constexpr bool CheckUnique(ComponentList<COMPONENTS...>*)
+			{
+				return ((count_v<COMPONENTS, COMPONENTS...> == 1) && ...);
 			}
-			template <typename T>
-			static constexpr auto info_v = Details::CreateInfo<T>();
 		} // details
 
-		// std::decay -> remove keyword const if needed
-		// this will create multiple references to the same structure
+		// pointers, references and const are looked through so function parameters can be used as is
+		template <typename T>
+		constexpr unsigned component_id_v = Details::ComponentID<std::remove_cvref_t<std::remove_pointer_t<std::remove_reference_t<T>>>>();
+
+		// shared components are stored once per archetype group instead of once per entity,
+		// entities with different values end up in different groups of the same archetype
+		// mark a component as shared with
+		// static constexpr bool isSharedComponent = true;
+		template <typename T>
+		concept is_shared_component = requires { T::isSharedComponent; } && T::isSharedComponent;
+
+		// tags are empty marker structs, they only take part in the archetype
+		// signature and in query matching, they never get any storage
 		template <typename T>
-		constexpr auto& component_info_v = Component::Details::template info_v<std::remove_pointer_t<std::remove_reference_t<std::decay<T>>>>;
+		concept is_tag_component = std::is_empty_v<T> && !is_shared_component<T>;
 
+		// components that can be moved to another slot with a raw memcpy, leaving the
+		// source slot as dead bytes that need no destructor call
+		// trivially copyable types qualify on their own, types that only hold
+		// handles with no self references can opt in by specialising this
 		template <typename T>
-		static constexpr int& bitOffset_v = component_info_v<T>.m_UID;
+		struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+		template <typename T>
+		constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+		// components that get a column holding one value per entity
+		template <typename T>
+		concept has_column_storage = !is_shared_component<T> && !is_tag_component<T>;
 
 		class ComponentManager
 		{
 		public:
 
+			// ids are fixed at compile time by ENGINE_COMPONENTS,
+			// this only checks that T has one
 			template<typename T_COMPONENT>
 			void RegisterComponent(void) noexcept
 			{
-				if (component_info_v<T_COMPONENT>.m_UID == -1)
-					component_info_v<T_COMPONENT>.m_UID = m_uniqueID++;
+				static_assert(component_id_v<T_COMPONENT> < ComponentBitset::Length);
 			}
-			int m_uniqueID = 0;
-
-			
 		};
 
 
 	}
 }
 
+// declares the application's components at global scope, before any system or query uses them
+// ENGINE_COMPONENTS(Sprite, Velocity, Position);
+// keep the order stable, it decides the signatures saved in snapshots
+#define ENGINE_COMPONENTS(...) \
+	template <> \
+	struct Engine::Component::application_components<void> \
+	{ \
+		using type = Engine::Component::ComponentList<__VA_ARGS__>; \
+		static_assert(Engine::Component::Details::CheckUnique(static_cast<type*>(nullptr)), "component listed twice in ENGINE_COMPONENTS"); \
+	}
@@ -2,8 +2,9 @@
 #include "Graphics/OpenGL/WinWrapper.h"
 #include "Graphics/GraphicsSystem.h"
 #include "Graphics/OpenGL/Sprite/Sprite.h"
-#include <chrono>
 #include "Logger.h"
+#include "JobSystem.h"
+#include "Graphics/OpenGL/RenderThread.h"
 
 Entity Engine::EngineManager::CloneEntity(Entity entity)
 {
@@ -14,29 +15,74 @@ Entity Engine::EngineManager::CloneEntity(Entity entity)
 void Engine::EngineManager::Run()
 {
   WinWrapper* winp = WinWrapper::GetInstance();
-  auto last = std::chrono::system_clock::now();
+  GraphicsSystem* gs = GraphicsSystem::GetInstance();
+  Rendering::RenderThread* renderer = Rendering::RenderThread::GetInstance();
+  // GL belongs to the render thread until the loop is left
+  renderer->Start(GraphicsSystem_OpenGL::GetInstance());
   while (winp->ManageMessage())
   {
-    std::chrono::duration<float> dur = std::chrono::system_clock::now() - last;
-    while (dur.count() < 0.016)
+    unsigned ticks = Pacer.BeginFrame();
+    Streamer.Update(EntMan);
+    for (unsigned i = 0; i < ticks; ++i)
     {
-      dur = std::chrono::system_clock::now() - last;
+      EntMan.AdvanceTimers();
+      SysMan.Run(EntMan);
+      HierMan.Propagate();
     }
-    SysMan.Run(EntMan);
-    last = std::chrono::system_clock::now();
+
+    // after the ticks so the keys are read from the positions that will be drawn
+    for (auto& sorter : Sorters)
+      sorter.Update(EntMan);
+
+    // hand memory back after mass despawns, the trim policy keeps this from thrashing
+    if (Pacer.GetTick() - m_lastTrimTick >= TrimIntervalTicks)
+    {
+      EntMan.Trim();
+      m_lastTrimTick = Pacer.GetTick();
+    }
+
+    // render systems only copy what is visible into the frame packet,
+    // it is drawn while the next frame simulates
+    gs->SetInterpolationAlpha(Pacer.GetAlpha());
+    RenderSysMan.Run(EntMan);
+    renderer->Submit();
+    Pacer.EndFrame();
   }
+  renderer->Stop();
+}
+
+Engine::EngineManager::EngineManager()
+{
+  // started here so the main thread is worker 0 and helps out whenever it waits
+  Jobs::JobSystem::GetInstance();
+
+  // an empty query matches every archetype, so this also catches entities
+  // deleted straight through EntMan
+  EntMan.AddObserver(EntityManager::ObserverEvent::OnRemove, Tools::Query{},
+    [this](Archetype::Archetype&, std::span<const Entity> entities)
+    {
+      for (Entity entity : entities)
+        HierMan.Remove(entity);
+    });
 }
 
 Engine::EngineManager::~EngineManager()
 {
+  // hands the context back before the graphics objects are cleaned up
+  Rendering::RenderThread::Exit();
   GraphicsSystem_OpenGL::Exit();
   WinWrapper::Exit();
+  Jobs::JobSystem::Exit();
   Logger::Drop();
 }
 
 void Engine::EngineManager::RunSystemOnce()
 {
+  EntMan.AdvanceTimers();
   SysMan.Run(EntMan);
+  HierMan.Propagate();
+  RenderSysMan.Run(EntMan);
+  Rendering::RenderThread::GetInstance()->Submit();
 }
 
 void Engine::EngineManager::Init(_In_ HINSTANCE hInstance,
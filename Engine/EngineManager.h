@@ -5,15 +5,38 @@
 #include "ComponentManager.h"
 #include "Archetype.h"
 #include "System.h"
+#include "FramePacer.h"
+#include "Hierarchy.h"
+#include "WorldStreamer.h"
+#include "RowSorter.h"
+#include <vector>
 
 namespace Engine
 {
 	class EngineManager
 	{
+		// how often archetype storage is trimmed, in simulation ticks
+		static constexpr uint64_t TrimIntervalTicks = 120;
+		uint64_t m_lastTrimTick = 0;
 	public:
 		EntityManager::EntityManager EntMan;
 		Component::ComponentManager CompMan;
 		System::details::SystemManager SysMan;
+		// systems that run once per frame after the simulation ticks,
+		// they fill the render thread's frame packet instead of drawing
+		System::details::SystemManager RenderSysMan;
+		Time::FramePacer Pacer;
+		// world transforms are propagated after every simulation tick
+		Hierarchy::HierarchyManager HierMan;
+		// worlds built in the background are merged in at the start of a frame
+		Streaming::WorldStreamer Streamer;
+		// keep archetype rows in an order that suits the queries, a few swaps every frame
+		std::vector<Sorting::RowSorter> Sorters;
+
+		void AddRowSorter(const Tools::Query& query, Sorting::RowSorter::KeyFunction key, size_t swapsPerUpdate = 1024, size_t resortInterval = 60)
+		{
+			Sorters.emplace_back(query, std::move(key), swapsPerUpdate, resortInterval);
+		}
 
 		template<typename T_COMPONENT>
 		void RegisterComponent(void) noexcept
@@ -27,10 +50,24 @@ namespace Engine
 			SysMan.RegisterSystem<System>();
 		}
 
+		// systems run in order as one, neighbouring functor systems over the same query are fused
+		template<typename... Systems>
+		void RegisterPipeline()
+		{
+			SysMan.RegisterPipeline<Systems...>();
+		}
+
+		template<typename System>
+		void RegisterRenderSystem()
+		{
+			RenderSysMan.RegisterSystem<System>();
+		}
+
 		Entity CloneEntity(Entity entity);
 
 		void Run();
 
+		EngineManager();
 		~EngineManager();
 
 		void RunSystemOnce();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 
 using Entity = uint64_t;
@@ -9,3 +10,13 @@ struct EntityComponent
 {
 	Entity entity;
 };
+
+// maps entities of a world that got merged into another to their new handles
+struct EntityRemap
+{
+	// indexed by the index of the entity in the old world
+	std::vector<Entity> table;
+
+	// returns 0 for entities that were not part of the merged world
+	Entity operator()(Entity entity) const;
+};
@@ -2,6 +2,10 @@
 #include "Logger.h"
 #include <algorithm>
 #include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <mutex>
 
 using namespace Engine::EntityManager;
 using namespace Engine;
@@ -86,6 +90,7 @@ Entity_details::EntityInfo& Engine::EntityManager::EntityDB::CreateEntity()
 	else
 	{
 		SetIndex(headOfFree, headOfFree + 1);
+		highWater = ExtractIndex(headOfFree);
 
 		if constexpr (Logger::LogEnabled())
 		{
@@ -110,10 +115,8 @@ Entity_details::EntityInfo& Engine::EntityManager::EntityDB::CreateEntity()
 	return info;
 }
 
-void Engine::EntityManager::EntityDB::DeleteEntity(Entity entity)
+void Engine::EntityManager::EntityDB::RemoveFromArchetype(Entity_details::EntityInfo& info)
 {
-
-	auto& info = GetEntityInfo(entity);
 	auto movedIdx = info.archetype->DeleteEntity(info.index);
 	
 	if constexpr (Logger::LogEnabled())
@@ -138,6 +141,13 @@ void Engine::EntityManager::EntityDB::DeleteEntity(Entity entity)
 
 		movedInfo.index = info.index;
 	}
+}
+
+void Engine::EntityManager::EntityDB::DeleteEntity(Entity entity)
+{
+
+	auto& info = GetEntityInfo(entity);
+	RemoveFromArchetype(info);
 
 	info.ent = headOfFree;
 	headOfFree = entity;
@@ -151,6 +161,15 @@ void Engine::EntityManager::EntityDB::DeleteEntity(Entity entity)
 	
 }
 
+void Engine::EntityManager::EntityDB::Clear()
+{
+	for (size_t i = 0; i < highWater; ++i)
+		m_data[i] = Entity_details::EntityInfo{};
+	headOfFree = 0;
+	SetIndex(headOfFree, 1);
+	highWater = 1;
+}
+
 Engine::EntityManager::EntityDB::EntityDB() :
 	m_data{ std::make_unique<Entity_details::EntityInfo[]>(MaxEntities) }
 {
@@ -182,8 +201,93 @@ void Engine::EntityManager::EntityManager::DeleteEntity(Entity ent)
 	m_destroyedEntities.push_back(ent);
 }
 
+void Engine::EntityManager::EntityManager::NotifyObservers(ObserverEvent event, std::vector<Entity>& entities)
+{
+	auto archetypeOf = [&](Entity ent)
+	{
+		return m_dataBase.GetEntityInfo(ent).archetype.get();
+	};
+	std::sort(entities.begin(), entities.end(), [&](Entity ent1, Entity ent2)
+		{
+			return archetypeOf(ent1) < archetypeOf(ent2);
+		});
+	// observers should see the same handle AddEntity gave out
+	for (auto& ent : entities)
+		ent &= ~ZombieMask;
+
+	size_t begin = 0;
+	while (begin < entities.size())
+	{
+		auto* archetype = archetypeOf(entities[begin]);
+		size_t end = begin + 1;
+		while (end < entities.size() && archetypeOf(entities[end]) == archetype)
+			++end;
+
+		auto& bits = m_archetype_bits[FindArchetypeIndex(archetype)];
+		std::span<const Entity> batch{ entities.data() + begin, end - begin };
+		// by index as observers may register more observers
+		for (size_t i = 0; i < m_observers.size(); ++i)
+		{
+			if (m_observers[i].event == event && m_observers[i].callback && m_observers[i].query.Compare(bits))
+				m_observers[i].callback(*archetype, batch);
+		}
+		begin = end;
+	}
+}
+
+void Engine::EntityManager::EntityManager::NotifyStructuralChanges()
+{
+	// drop observers removed since the last sync
+	m_observers.erase(std::remove_if(m_observers.begin(), m_observers.end(),
+		[](const Observer& observer) { return !observer.callback; }), m_observers.end());
+
+	if (!m_addedEntities.empty())
+	{
+		// anything added by the observers goes into the next batch
+		std::vector<Entity> added;
+		added.swap(m_addedEntities);
+		NotifyObservers(ObserverEvent::OnAdd, added);
+	}
+
+	// observers may delete more entities, keep going until
+	// every entity about to be removed has been reported
+	size_t notified = 0;
+	while (notified < m_destroyedEntities.size())
+	{
+		std::vector<Entity> removed(m_destroyedEntities.begin() + notified, m_destroyedEntities.end());
+		notified = m_destroyedEntities.size();
+		NotifyObservers(ObserverEvent::OnRemove, removed);
+	}
+}
+
+Engine::EntityManager::ObserverHandle Engine::EntityManager::EntityManager::AddObserver(
+	ObserverEvent event, const Tools::Query& query, ObserverCallback callback)
+{
+	if (event == ObserverEvent::OnAdd)
+		++m_addObserverCount;
+	m_observers.push_back(Observer{ event, query, std::move(callback), m_nextObserverHandle });
+	return m_nextObserverHandle++;
+}
+
+void Engine::EntityManager::EntityManager::RemoveObserver(ObserverHandle handle)
+{
+	for (auto& observer : m_observers)
+	{
+		if (observer.handle != handle || !observer.callback)
+			continue;
+		// erased at the next sync, we may be inside one of the callbacks right now
+		observer.callback = nullptr;
+		if (observer.event == ObserverEvent::OnAdd && --m_addObserverCount == 0)
+			m_addedEntities.clear();
+		return;
+	}
+}
+
 void Engine::EntityManager::EntityManager::UpdateStructuralComponents()
 {
+	if (!m_observers.empty())
+		NotifyStructuralChanges();
+
 	std::sort(
 			m_destroyedEntities.begin(),
 			m_destroyedEntities.end(),
@@ -198,6 +302,510 @@ void Engine::EntityManager::EntityManager::UpdateStructuralComponents()
 		m_dataBase.DeleteEntity(m_destroyedEntities[i]);
 	}
 	m_destroyedEntities.clear();
+
+	// reap a finished background snapshot
+	if (m_asyncSnapshot && m_asyncSnapshot->IsDone())
+		WaitForSnapshot();
+}
+
+size_t Engine::EntityManager::EntityManager::FindArchetypeIndex(const Archetype::Archetype* archetype) const
+{
+	for (size_t i = 0; i < m_archetypeList.size(); ++i)
+	{
+		if (m_archetypeList[i].get() == archetype)
+			return i;
+	}
+	assert(false);
+	return 0;
+}
+
+namespace
+{
+	struct ArchetypeFactoryEntry
+	{
+		Engine::Component::ComponentBitset bits;
+		std::vector<unsigned> order;
+		std::shared_ptr<Engine::Archetype::Archetype>(*create)();
+	};
+	// worlds can be built on worker threads so registration has to be guarded
+	std::mutex s_factoryLock;
+	std::vector<ArchetypeFactoryEntry> s_archetypeFactories;
+}
+
+Engine::EntityManager::EntityManager::ArchetypeFactory
+Engine::EntityManager::EntityManager::FindArchetypeFactory(const Component::ComponentBitset& bits, const std::vector<unsigned>& order)
+{
+	std::lock_guard lock{ s_factoryLock };
+	for (auto& entry : s_archetypeFactories)
+	{
+		if (entry.bits == bits && entry.order == order)
+			return entry.create;
+	}
+	return nullptr;
+}
+
+void Engine::EntityManager::EntityManager::AddArchetypeFactory(const Component::ComponentBitset& bits, std::vector<unsigned> order, ArchetypeFactory create)
+{
+	std::lock_guard lock{ s_factoryLock };
+	for (auto& entry : s_archetypeFactories)
+	{
+		if (entry.order == order)
+			return;
+	}
+	s_archetypeFactories.push_back({ bits, std::move(order), create });
+}
+
+void Engine::EntityManager::EntityManager::Clear()
+{
+	// the snapshot may still be reading the columns
+	WaitForSnapshot();
+
+	if (!m_observers.empty())
+	{
+		// report what is pending first, then everything that is left as removed
+		UpdateStructuralComponents();
+		for (size_t a = 0; a < m_archetypeList.size(); ++a)
+		{
+			auto& archetype = *m_archetypeList[a];
+			if (!archetype.entityNum)
+				continue;
+			// the entity column is laid out as a plain array of Entity
+			auto* first = &archetype.GetComponent<EntityComponent>(0).entity;
+			std::span<const Entity> batch{ first, archetype.entityNum };
+			for (size_t i = 0; i < m_observers.size(); ++i)
+			{
+				if (m_observers[i].event == ObserverEvent::OnRemove && m_observers[i].callback &&
+					m_observers[i].query.Compare(m_archetype_bits[a]))
+					m_observers[i].callback(archetype, batch);
+			}
+		}
+	}
+	m_destroyedEntities.clear();
+	m_addedEntities.clear();
+	m_timers.Clear();
+	// drop the database's references first so the archetypes die with the list
+	m_dataBase.Clear();
+	m_archetypeList.clear();
+	m_archetype_bits.clear();
+}
+
+/*
+layout
+	magic, version
+	entity high water mark, head of free list
+	the ent of every EntityDB slot below the high water mark
+	archetype count
+	for each archetype
+		signature bits
+		component count, then the component ids in the order their columns follow
+		shared component values
+		entity count
+		for each column, component size followed by the column
+	timer count
+	for each timer, entity, channel and ticks left
+*/
+void Engine::EntityManager::EntityManager::WriteSnapshot(Snapshot::Writer& writer)
+{
+	UpdateStructuralComponents();
+
+	writer.Write(Snapshot::Magic);
+	writer.Write(Snapshot::Version);
+
+	// the free list is threaded through ent so this is enough to restore the database
+	writer.Write<uint64_t>(m_dataBase.highWater);
+	writer.Write(m_dataBase.headOfFree);
+	std::vector<Entity> ents(m_dataBase.highWater);
+	for (size_t i = 0; i < ents.size(); ++i)
+		ents[i] = m_dataBase.m_data[i].ent;
+	writer.Write(ents.data(), ents.size() * sizeof(Entity));
+
+	writer.Write<uint64_t>(m_archetypeList.size());
+	for (size_t i = 0; i < m_archetypeList.size(); ++i)
+	{
+		writer.Write(m_archetype_bits[i].data, sizeof(m_archetype_bits[i].data));
+		std::vector<unsigned> order = m_archetypeList[i]->GetComponentOrder();
+		writer.Write<uint32_t>(static_cast<uint32_t>(order.size()));
+		for (unsigned id : order)
+			writer.Write<uint32_t>(id);
+		m_archetypeList[i]->Serialize(writer);
+	}
+
+	writer.Write<uint64_t>(m_timers.GetCount());
+	m_timers.ForEach([&writer](Entity entity, Time::TimerChannel channel, uint64_t remaining)
+		{
+			writer.Write(entity);
+			writer.Write(channel);
+			writer.Write(remaining);
+		});
+}
+
+bool Engine::EntityManager::EntityManager::SaveSnapshot(const std::string& path)
+{
+	std::ofstream fs(path, std::ios::binary | std::ios::trunc);
+	if (!fs)
+	{
+		Logger::GetInstance()->Log("Failed to open snapshot for writing: " + path + "\n");
+		return false;
+	}
+	Snapshot::Writer writer{ fs };
+	WriteSnapshot(writer);
+
+	if (!writer.Good())
+	{
+		Logger::GetInstance()->Log("Failed to write snapshot: " + path + "\n");
+		return false;
+	}
+	return true;
+}
+
+bool Engine::EntityManager::EntityManager::LoadSnapshot(const std::string& path)
+{
+	Snapshot::MappedFile file{ path };
+	if (!file.IsOpen())
+	{
+		Logger::GetInstance()->Log("Failed to open snapshot: " + path + "\n");
+		return false;
+	}
+	Snapshot::Reader reader{ file.GetData(), file.GetSize() };
+
+	if (reader.Read<uint32_t>() != Snapshot::Magic || reader.Read<uint32_t>() != Snapshot::Version)
+	{
+		Logger::GetInstance()->Log("Snapshot has an unknown format or version: " + path + "\n");
+		return false;
+	}
+
+	// everything is parsed into locals first so a corrupt file leaves the world untouched
+	auto highWater = reader.Read<uint64_t>();
+	auto headOfFree = reader.Read<Entity>();
+	const char* ents = highWater <= MaxEntities ? reader.Take(highWater * sizeof(Entity)) : nullptr;
+	if (!ents)
+	{
+		Logger::GetInstance()->Log("Snapshot entity table is corrupt: " + path + "\n");
+		return false;
+	}
+
+	std::vector<std::shared_ptr<Archetype::Archetype>> archetypes;
+	std::vector<Component::ComponentBitset> archetypeBits;
+	auto archetypeCount = reader.Read<uint64_t>();
+	for (uint64_t a = 0; a < archetypeCount && !reader.Failed(); ++a)
+	{
+		Component::ComponentBitset bits;
+		reader.Read(bits.data, sizeof(bits.data));
+
+		auto componentCount = reader.Read<uint32_t>();
+		if (reader.Failed() || componentCount > Component::ComponentBitset::Length)
+		{
+			Logger::GetInstance()->Log("Snapshot archetype component list is corrupt: " + path + "\n");
+			return false;
+		}
+		std::vector<unsigned> order(componentCount);
+		for (unsigned& id : order)
+			id = reader.Read<uint32_t>();
+
+		// the same components in another order would load their columns swapped
+		auto create = FindArchetypeFactory(bits, order);
+		if (!create)
+		{
+			Logger::GetInstance()->Log("Snapshot contains an archetype that was never registered with its components in this order: " + path + "\n");
+			return false;
+		}
+
+		auto archetype = create();
+		if (!archetype->Deserialize(reader))
+		{
+			Logger::GetInstance()->Log("Snapshot archetype data does not match its components: " + path + "\n");
+			return false;
+		}
+		// every row has to belong to a slot of the entity table
+		auto& entities = dynamic_cast<Archetype::Archetype_Intermediate<EntityComponent>&>(*archetype);
+		for (Archetype::ChunkIndex row = 0; row < archetype->entityNum; ++row)
+		{
+			if (EntityHelper::ExtractIndex(entities.GetComponent(row).entity) >= highWater)
+			{
+				Logger::GetInstance()->Log("Snapshot archetype refers to an entity outside the entity table: " + path + "\n");
+				return false;
+			}
+		}
+		archetypes.push_back(std::move(archetype));
+		archetypeBits.push_back(bits);
+	}
+
+	struct PendingTimer
+	{
+		Entity entity;
+		Time::TimerChannel channel;
+		uint64_t remaining;
+	};
+	std::vector<PendingTimer> timers;
+	auto timerCount = reader.Read<uint64_t>();
+	for (uint64_t t = 0; t < timerCount && !reader.Failed(); ++t)
+	{
+		PendingTimer timer;
+		timer.entity = reader.Read<Entity>();
+		timer.channel = reader.Read<Time::TimerChannel>();
+		timer.remaining = reader.Read<uint64_t>();
+		timers.push_back(timer);
+	}
+	if (reader.Failed())
+	{
+		Logger::GetInstance()->Log("Snapshot is truncated: " + path + "\n");
+		return false;
+	}
+
+	// the whole file is good, swap it in
+	Clear();
+	for (size_t i = 0; i < highWater; ++i)
+		std::memcpy(&m_dataBase.m_data[i].ent, ents + i * sizeof(Entity), sizeof(Entity));
+	m_dataBase.highWater = highWater;
+	m_dataBase.headOfFree = headOfFree;
+
+	for (size_t a = 0; a < archetypes.size(); ++a)
+	{
+		auto& archetype = archetypes[a];
+		m_archetypeList.push_back(archetype);
+		m_archetype_bits.push_back(archetypeBits[a]);
+
+		// point the database back at the rows, the entity column tells us who is where
+		auto& entities = dynamic_cast<Archetype::Archetype_Intermediate<EntityComponent>&>(*archetype);
+		for (Archetype::ChunkIndex row = 0; row < archetype->entityNum; ++row)
+		{
+			auto& info = m_dataBase.GetEntityInfo(entities.GetComponent(row).entity);
+			info.archetype = archetype;
+			info.index = row;
+			// loaded entities are reported as added at the next sync
+			if (m_addObserverCount)
+				m_addedEntities.push_back(info.ent);
+		}
+	}
+
+	for (auto& timer : timers)
+		m_timers.Schedule(timer.entity, timer.channel, timer.remaining);
+	return true;
+}
+
+float Engine::EntityManager::MemoryReport::GetFragmentation() const
+{
+	return committed ? 1.f - static_cast<float>(live) / committed : 0.f;
+}
+
+std::string Engine::EntityManager::MemoryReport::ToString() const
+{
+	auto kb = [](size_t bytes)
+	{
+		return std::to_string(bytes / 1024) + "KB";
+	};
+	std::string res = "Entity database: " + kb(entityDatabase) + "\n";
+	res += "Columns committed: " + kb(committed) + " live: " + kb(live) +
+		" fragmentation: " + std::to_string(GetFragmentation()) + "\n";
+	for (size_t i = 0; i < archetypes.size(); ++i)
+	{
+		auto& archetype = archetypes[i];
+		res += "Archetype " + std::to_string(i) + " entities: " + std::to_string(archetype.entityNum) +
+			" committed: " + kb(archetype.committed) + " live: " + kb(archetype.live) + "\n";
+		for (auto& column : archetype.columns)
+		{
+			res += "\t";
+			res += column.componentName;
+			res += " committed: " + kb(column.committed) + " live: " + kb(column.live) + "\n";
+		}
+	}
+	return res;
+}
+
+void Engine::EntityManager::EntityManager::SwapRows(Archetype::Archetype& archetype, Archetype::ChunkIndex a, Archetype::ChunkIndex b)
+{
+	if (a == b)
+		return;
+	archetype.SwapRows(a, b);
+	m_dataBase.GetEntityInfo(archetype.GetComponent<EntityComponent>(a).entity).index = a;
+	m_dataBase.GetEntityInfo(archetype.GetComponent<EntityComponent>(b).entity).index = b;
+}
+
+Engine::EntityManager::MemoryReport Engine::EntityManager::EntityManager::GetMemoryReport() const
+{
+	MemoryReport report;
+	report.entityDatabase = MaxEntities * sizeof(Entity_details::EntityInfo);
+	report.archetypes.resize(m_archetypeList.size());
+	for (size_t i = 0; i < m_archetypeList.size(); ++i)
+	{
+		auto& archetype = report.archetypes[i];
+		archetype.bits = m_archetype_bits[i];
+		archetype.entityNum = m_archetypeList[i]->entityNum;
+		m_archetypeList[i]->GetMemory(archetype.columns);
+		for (auto& column : archetype.columns)
+		{
+			archetype.reserved += column.reserved;
+			archetype.committed += column.committed;
+			archetype.live += column.live;
+		}
+		report.reserved += archetype.reserved;
+		report.committed += archetype.committed;
+		report.live += archetype.live;
+	}
+	return report;
+}
+
+size_t Engine::EntityManager::EntityManager::Trim(const Archetype::TrimPolicy& policy)
+{
+	if (IsSnapshotInProgress())
+		return 0;
+
+	size_t released = 0;
+	// groups left empty when their shared value went out of use, the first group
+	// of an archetype stays so looking it up by signature keeps working
+	for (size_t i = m_archetypeList.size(); i-- > 0;)
+	{
+		if (m_archetypeList[i]->entityNum)
+			continue;
+		bool first = true;
+		for (size_t j = 0; j < i && first; ++j)
+			first = m_archetype_bits[j] != m_archetype_bits[i];
+		if (first)
+			continue;
+
+		std::vector<Archetype::ColumnMemory> columns;
+		m_archetypeList[i]->GetMemory(columns);
+		for (auto& column : columns)
+			released += column.committed;
+		m_archetypeList.erase(m_archetypeList.begin() + i);
+		m_archetype_bits.erase(m_archetype_bits.begin() + i);
+	}
+
+	for (auto& archetype : m_archetypeList)
+		released += archetype->Trim(policy);
+
+	if constexpr (Logger::LogEnabled())
+	{
+		if (released)
+			Logger::GetInstance()->Log("Trimmed " + std::to_string(released) + " bytes of archetype storage\n");
+	}
+	return released;
+}
+
+Entity EntityRemap::operator()(Entity entity) const
+{
+	size_t index = ExtractIndex(entity);
+	return index < table.size() ? table[index] : 0;
+}
+
+EntityRemap Engine::EntityManager::EntityManager::Merge(EntityManager& source)
+{
+	source.UpdateStructuralComponents();
+	source.WaitForSnapshot();
+
+	EntityRemap remap;
+	remap.table.resize(source.m_dataBase.highWater, 0);
+
+	struct MergedRange
+	{
+		Archetype::Archetype* archetype;
+		Archetype::ChunkIndex begin;
+		Archetype::ChunkIndex end;
+	};
+	std::vector<MergedRange> merged;
+
+	for (size_t s = 0; s < source.m_archetypeList.size(); ++s)
+	{
+		auto& sourceArchetype = source.m_archetypeList[s];
+		auto& bits = source.m_archetype_bits[s];
+		if (!sourceArchetype->entityNum)
+			continue;
+
+		std::shared_ptr<Archetype::Archetype> target;
+		for (size_t i = 0; i < m_archetypeList.size(); ++i)
+		{
+			if (m_archetype_bits[i] == bits && m_archetypeList[i]->SharedEquals(*sourceArchetype))
+			{
+				target = m_archetypeList[i];
+				break;
+			}
+		}
+
+		auto count = static_cast<Archetype::ChunkIndex>(sourceArchetype->entityNum);
+		Archetype::ChunkIndex first = 0;
+		if (target)
+		{
+			first = target->AppendFrom(*sourceArchetype);
+		}
+		else
+		{
+			// nothing to append to so the whole archetype comes over without copying
+			target = sourceArchetype;
+			m_archetypeList.push_back(target);
+			m_archetype_bits.push_back(bits);
+		}
+
+		auto& entities = dynamic_cast<Archetype::Archetype_Intermediate<EntityComponent>&>(*target);
+		for (Archetype::ChunkIndex row = first; row < first + count; ++row)
+		{
+			auto& entity = entities.GetComponent(row).entity;
+			auto& info = m_dataBase.CreateEntity();
+			info.archetype = target;
+			info.index = row;
+			remap.table[ExtractIndex(entity)] = info.ent;
+			entity = info.ent;
+			if (m_addObserverCount)
+				m_addedEntities.push_back(info.ent);
+		}
+		merged.push_back({ target.get(), first, first + count });
+	}
+
+	// only once everything has its new handle, entities can point across archetypes
+	for (auto& range : merged)
+		range.archetype->RemapEntities(range.begin, range.end, remap);
+
+	// timers of entities deleted in source could map onto whoever reused their index
+	source.m_timers.ForEach([&](Entity entity, Time::TimerChannel channel, uint64_t remaining)
+		{
+			if (source.IsAlive(entity))
+				m_timers.Schedule(remap(entity), channel, remaining);
+		});
+	source.m_timers.Clear();
+
+	source.m_dataBase.Clear();
+	source.m_archetypeList.clear();
+	source.m_archetype_bits.clear();
+	source.m_addedEntities.clear();
+
+	return remap;
+}
+
+bool Engine::EntityManager::EntityManager::SaveSnapshotAsync(const std::string& path)
+{
+	if (IsSnapshotInProgress())
+	{
+		Logger::GetInstance()->Log("Snapshot already in progress, skipping: " + path + "\n");
+		return false;
+	}
+
+	auto snapshot = std::make_unique<Snapshot::AsyncSnapshot>(path);
+	WriteSnapshot(*snapshot);
+	// archetypes deleted while the snapshot runs must keep their columns around
+	for (auto& archetype : m_archetypeList)
+		snapshot->KeepAlive(archetype);
+	snapshot->Start();
+	// kept even if freezing failed, the background thread still has to finish with the pages
+	bool started = snapshot->Good();
+	m_asyncSnapshot = std::move(snapshot);
+	return started;
+}
+
+bool Engine::EntityManager::EntityManager::IsSnapshotInProgress()
+{
+	if (m_asyncSnapshot && m_asyncSnapshot->IsDone())
+		WaitForSnapshot();
+	return m_asyncSnapshot != nullptr;
+}
+
+bool Engine::EntityManager::EntityManager::WaitForSnapshot()
+{
+	if (!m_asyncSnapshot)
+		return true;
+	bool res = m_asyncSnapshot->Wait();
+	if (!res)
+		Logger::GetInstance()->Log("Failed to write async snapshot\n");
+	m_asyncSnapshot.reset();
+	return res;
 }
 
 bool Engine::EntityManager::EntityManager::IsZombie(Entity ent)
@@ -205,6 +813,26 @@ bool Engine::EntityManager::EntityManager::IsZombie(Entity ent)
 	return m_dataBase.IsZombie(ent);;
 }
 
+bool Engine::EntityManager::EntityManager::IsAlive(Entity ent) const
+{
+	size_t index = ExtractIndex(ent);
+	if (!index || index >= m_dataBase.highWater)
+		return false;
+	// a deleted slot holds the free list link instead, and a queued deletion sets the zombie bit
+	return m_dataBase.m_data[index].ent == (ent & ~ZombieMask);
+}
+
+Engine::Time::TimerWheel& Engine::EntityManager::EntityManager::GetTimers()
+{
+	return m_timers;
+}
+
+void Engine::EntityManager::EntityManager::AdvanceTimers()
+{
+	m_timers.Advance();
+	m_timers.FilterFired([this](Entity ent) { return IsAlive(ent); });
+}
+
 Entity Engine::EntityManager::EntityManager::CloneEntity(Entity entity)
 {
 	return Entity();
@@ -5,27 +5,35 @@
 #include "Bitset.h"
 #include "ComponentManager.h"
 #include "Query.h"
+#include "AsyncSnapshot.h"
+#include "TimerWheel.h"
 #include <deque>
 #include <memory>
 #include <vector>
+#include <string>
+#include <span>
+#include <functional>
 #include "Logger.h"
 
 namespace Engine
 {
 	namespace helper
 	{
-		template <typename COMPONENT1, typename ...COMPONENT_REST>
-		Component::ComponentBitset BitsetExpansion()
+		template <typename T, typename... LIST>
+		constexpr bool contains_v = (std::is_same_v<T, LIST> || ...);
+
+		template <typename... COMPONENTS>
+		constexpr Component::ComponentBitset BitsetExpansion()
 		{
-			if constexpr (sizeof...(COMPONENT_REST) > 0)
-			{
-				auto temp = Component::component_info_v<COMPONENT1>.m_UID;
-				return  Component::ComponentBitset(temp) + BitsetExpansion<COMPONENT_REST...>();
-			}
-			else
-				return Component::ComponentBitset(Component::bitOffset_v<COMPONENT1>);
+			Component::ComponentBitset bits;
+			(bits.Set(Component::component_id_v<COMPONENTS>), ...);
+			return bits;
 		}
 
+		// archetype signature of COMPONENTS, a constant so looking it up costs nothing
+		template <typename... COMPONENTS>
+		constexpr Component::ComponentBitset signature_v = BitsetExpansion<COMPONENTS...>();
+
 	}
 
 	class ArchetypeVector
@@ -81,6 +89,8 @@ namespace Engine
 			std::unique_ptr<Entity_details::EntityInfo[]> m_data;
 			// reserve 0 as invalid entity
 			Entity headOfFree = 0;
+			// one past the highest index ever handed out
+			size_t highWater = 1;
 
 			bool IsZombie(Entity entity);
 			Entity ToggleZombie(Entity entity);
@@ -88,24 +98,118 @@ namespace Engine
 			Entity SetZombie(Entity entity);
 			Entity_details::EntityInfo& GetEntityInfo(Entity entity);
 			Entity_details::EntityInfo& CreateEntity();
+			// removes the entity's row from its archetype and fixes up
+			// the entity that got swapped into its place, the entity stays alive
+			void RemoveFromArchetype(Entity_details::EntityInfo& info);
 			void DeleteEntity(Entity entity);
+			// forgets every entity, indices start from 1 again
+			void Clear();
 			EntityDB();
 		};
 
+		enum class ObserverEvent
+		{
+			OnAdd,
+			// delivered before the entities are removed so their components can still be read
+			OnRemove
+		};
+
+		// called once per archetype with all of its entities that were added or
+		// are being removed since the last UpdateStructuralComponents
+		using ObserverCallback = std::function<void(Archetype::Archetype& archetype, std::span<const Entity> entities)>;
+		using ObserverHandle = size_t;
+
+		struct ArchetypeMemory
+		{
+			Component::ComponentBitset bits;
+			size_t entityNum = 0;
+			std::vector<Archetype::ColumnMemory> columns;
+			size_t reserved = 0;
+			size_t committed = 0;
+			size_t live = 0;
+		};
+
+		struct MemoryReport
+		{
+			std::vector<ArchetypeMemory> archetypes;
+			// the entity database is allocated up front for MaxEntities
+			size_t entityDatabase = 0;
+			size_t reserved = 0;
+			size_t committed = 0;
+			size_t live = 0;
+
+			// fraction of the committed column memory not holding components
+			float GetFragmentation() const;
+			std::string ToString() const;
+		};
+
 		class EntityManager
 		{
 			EntityDB m_dataBase;
 
+			struct Observer
+			{
+				ObserverEvent event;
+				Tools::Query query;
+				ObserverCallback callback;
+				ObserverHandle handle;
+			};
+			std::vector<Observer> m_observers;
+			ObserverHandle m_nextObserverHandle = 1;
+			// only track added entities while someone is listening for them
+			size_t m_addObserverCount = 0;
+			std::vector<Entity> m_addedEntities;
+
+			// groups entities by archetype and hands each group to the matching observers
+			void NotifyObservers(ObserverEvent event, std::vector<Entity>& entities);
+			void NotifyStructuralChanges();
+
 			std::shared_ptr<Archetype::Archetype_Impl<>> m_emptyArchetype;
 			std::deque<std::shared_ptr<Archetype::Archetype>>  m_archetypeList;
 			std::deque<Component::ComponentBitset > m_archetype_bits;
 
 			std::vector<Entity> m_destroyedEntities;
+
+			Time::TimerWheel m_timers;
+
+			// creates an empty archetype for a signature, used when loading snapshots
+			// shared by every EntityManager so worlds built on other threads can load them too
+			using ArchetypeFactory = std::shared_ptr<Archetype::Archetype>(*)();
+
+			template<typename... COMPONENTS>
+			static std::shared_ptr<Archetype::Archetype> CreateArchetype()
+			{
+				return std::make_shared<Archetype::Archetype_Impl<COMPONENTS...>>();
+			}
+
+			// order is the component ids in template order, the same set in another order
+			// lays its columns out differently so it needs a factory of its own
+			static ArchetypeFactory FindArchetypeFactory(const Component::ComponentBitset& bits, const std::vector<unsigned>& order);
+			// does nothing if order already has a factory
+			static void AddArchetypeFactory(const Component::ComponentBitset& bits, std::vector<unsigned> order, ArchetypeFactory create);
+
+			void WriteSnapshot(Snapshot::Writer& writer);
+
+			// declared last so it is waited on before anything else is torn down
+			std::unique_ptr<Snapshot::AsyncSnapshot> m_asyncSnapshot;
+
+			size_t FindArchetypeIndex(const Archetype::Archetype* archetype) const;
 		public:
+			// lets snapshots containing this archetype be loaded before any entity
+			// with it has been created, AddEntity registers archetypes on its own
+			// snapshots record the order columns were saved in and only load
+			// into an archetype registered in that order, so use the same order as AddEntity
+			template<typename... COMPONENTS>
+			static void RegisterArchetype()
+			{
+				AddArchetypeFactory(helper::signature_v<COMPONENTS...>,
+					{ Component::component_id_v<COMPONENTS>... }, &CreateArchetype<COMPONENTS...>);
+			}
+
 			template<typename... COMPONENTS>
 			std::shared_ptr<Archetype::Archetype> Search()
 			{
-				auto bits = helper::BitsetExpansion<COMPONENTS...>();
+				const auto& bits = helper::signature_v<COMPONENTS...>;
 				return Search(bits);
 			}
 
@@ -129,24 +233,54 @@ namespace Engine
 				return {};
 			}
 
-			template<typename... COMPONENTS>
-			Entity AddEntity()
+			// finds the archetype group holding COMPONENTS whose shared components
+			// match the given values
+			template<typename... COMPONENTS, typename... SHARED>
+			std::shared_ptr<Archetype::Archetype_Impl<COMPONENTS...>> FindArchetype(const SHARED&... sharedValues)
 			{
-				auto dyn = std::dynamic_pointer_cast<Archetype::Archetype_Impl<COMPONENTS...>>(Search<COMPONENTS...>());
+				const auto& bits = helper::signature_v<COMPONENTS...>;
+				for (size_t i = 0; i < m_archetype_bits.size(); ++i)
+				{
+					if (m_archetype_bits[i] != bits)
+						continue;
+					auto dyn = std::dynamic_pointer_cast<Archetype::Archetype_Impl<COMPONENTS...>>(m_archetypeList[i]);
+					if (dyn && ((dyn->template GetSharedComponent<SHARED>() == sharedValues) && ...))
+						return dyn;
+				}
+				return {};
+			}
+
+			// every shared component in COMPONENTS needs its value passed in
+			// e.g. AddEntity<Position, Sprite>(sprite);
+			template<typename... COMPONENTS, typename... SHARED>
+			Entity AddEntity(const SHARED&... sharedValues)
+			{
+				static_assert((Component::is_shared_component<SHARED> && ...),
+					"only shared components can be passed by value to AddEntity");
+				static_assert((helper::contains_v<SHARED, COMPONENTS...> && ...),
+					"shared value passed for a component that is not in the archetype");
+				static_assert((0 + ... + Component::is_shared_component<COMPONENTS>) == sizeof...(SHARED),
+					"every shared component must be given a value when adding an entity");
+
+				auto dyn = FindArchetype<COMPONENTS...>(sharedValues...);
 				// search for the appropriate archetype and add an entity to it
 				if (!dyn)
 				{
 					dyn = std::make_shared<Archetype::Archetype_Impl<COMPONENTS...>>();
-					auto bits = helper::BitsetExpansion<COMPONENTS...>();
+					((dyn->template GetSharedComponent<SHARED>() = sharedValues), ...);
+					const auto& bits = helper::signature_v<COMPONENTS...>;
 
 					m_archetypeList.push_back(dyn);
 					m_archetype_bits.push_back(bits);
+					RegisterArchetype<COMPONENTS...>();
 				}
 				Archetype::ChunkIndex index = dyn->AddEntity();
 				auto& info = m_dataBase.CreateEntity();
 				info.archetype = dyn;
 				info.index = index;
 				dyn->GetComponent<EntityComponent>(index).entity = info.ent;
+				if (m_addObserverCount)
+					m_addedEntities.push_back(info.ent);
 
 				if constexpr (Logger::LogEnabled())
 				{
@@ -158,10 +292,112 @@ namespace Engine
 				return info.ent;
 			}
 
+			// moves the entity into the group of its archetype that has value for T
+			// this is a structural change so do not call it while iterating the entity's archetype
+			template<typename T>
+			void SetSharedComponent(Entity entity, const T& value)
+			{
+				static_assert(Component::is_shared_component<T>, "T is not a shared component");
+
+				auto& info = m_dataBase.GetEntityInfo(entity);
+				auto& shared = info.archetype->GetSharedComponent<T>();
+				if (shared == value)
+					return;
+
+				// the other groups are compared against this one with value swapped in,
+				// a new archetype reserves address space for every column so it is only made when needed
+				T previous = shared;
+				shared = value;
+
+				size_t current = FindArchetypeIndex(info.archetype.get());
+				std::shared_ptr<Archetype::Archetype> target;
+				std::shared_ptr<Archetype::Archetype> empty;
+				for (size_t i = 0; i < m_archetypeList.size(); ++i)
+				{
+					if (i == current || m_archetype_bits[i] != m_archetype_bits[current])
+						continue;
+					if (m_archetypeList[i]->SharedEquals(*info.archetype))
+					{
+						target = m_archetypeList[i];
+						break;
+					}
+					if (!empty && !m_archetypeList[i]->entityNum)
+						empty = m_archetypeList[i];
+				}
+				if (!target && empty)
+				{
+					// a group nobody is in any more takes the new value instead
+					target = empty;
+					target->CopySharedFrom(*info.archetype);
+				}
+				else if (!target)
+				{
+					target = info.archetype->CloneEmpty();
+					m_archetypeList.push_back(target);
+					m_archetype_bits.push_back(m_archetype_bits[current]);
+				}
+				shared = previous;
+
+				Archetype::ChunkIndex newIndex = info.archetype->MoveEntityTo(info.index, *target);
+				m_dataBase.RemoveFromArchetype(info);
+				info.archetype = target;
+				info.index = newIndex;
+			}
+
 			void DeleteEntity(Entity ent);
 
 			void UpdateStructuralComponents();
 
+			// observers are only ever called from UpdateStructuralComponents
+			// entities they add are reported at the next sync, entities they delete are
+			// reported in the same sync so every removal is seen before the rows go away
+			ObserverHandle AddObserver(ObserverEvent event, const Tools::Query& query, ObserverCallback callback);
+
+			// observe every archetype that has COMPONENT
+			template<typename COMPONENT>
+			ObserverHandle AddObserver(ObserverEvent event, ObserverCallback callback)
+			{
+				return AddObserver(event, Tools::query_v<Tools::Query::must<COMPONENT>>, std::move(callback));
+			}
+
+			// safe to call from inside an observer
+			void RemoveObserver(ObserverHandle handle);
+
+			// removes every entity and archetype
+			void Clear();
+
+			// writes every archetype's signature and columns to a binary file
+			// pending deletions are processed first
+			bool SaveSnapshot(const std::string& path);
+			// replaces the current world with the one in the file
+			// entities keep the handles they had when saved, the world is left as it was if the file is bad
+			bool LoadSnapshot(const std::string& path);
+
+			// swaps two rows of an archetype and points the database at their new places
+			void SwapRows(Archetype::Archetype& archetype, Archetype::ChunkIndex a, Archetype::ChunkIndex b);
+
+			MemoryReport GetMemoryReport() const;
+			// hands unused tail pages of the columns back to the OS and drops empty shared component
+			// groups other than the first of each archetype, returns the bytes released
+			// does nothing while an async snapshot is in progress as its pages may be frozen
+			size_t Trim(const Archetype::TrimPolicy& policy = {});
+
+			// moves every entity of source into this world, source is left empty
+			// archetypes this world does not have yet are taken over as they are,
+			// the rest have their columns appended in one copy per column
+			// entities get new handles, components with RemapEntities are fixed up
+			// and the returned table can be used for any other handles that were kept
+			EntityRemap Merge(EntityManager& source);
+
+			// same file as SaveSnapshot but written on a background thread,
+			// the world can keep changing while it is being written
+			// returns false if a snapshot is already in progress
+			bool SaveSnapshotAsync(const std::string& path);
+			// also cleans up the last snapshot once it has finished
+			bool IsSnapshotInProgress();
+			// returns whether the last async snapshot was written successfully
+			bool WaitForSnapshot();
+
 			template<typename Component>
 			std::decay_t<Component>& GetComponent(Entity entity)
 			{
@@ -178,6 +414,13 @@ namespace Engine
 			}
 
 			bool IsZombie(Entity ent);
+			// false once the entity has been deleted, even before the deletion is processed
+			bool IsAlive(Entity ent) const;
+
+			// per entity timers counted in simulation ticks, saved with snapshots and carried over by Merge
+			Time::TimerWheel& GetTimers();
+			// moves the timers on a tick, fired timers of entities that are no longer alive are dropped
+			void AdvanceTimers();
 
 			template<typename Component>
 			void AddComponent(Entity entity)
@@ -0,0 +1,252 @@
+#include "FileWatcher.h"
+#include "Logger.h"
+#include <cassert>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace Engine::Files;
+
+namespace
+{
+	std::string Join(const std::string& directory, const std::string& name)
+	{
+		return FileWatcher::Normalise((std::filesystem::path(directory) / name).generic_string());
+	}
+}
+
+FileWatcher::FileWatcher(Callback onChange) :
+	m_onChange{ std::move(onChange) }
+{
+#ifdef _WIN32
+	m_stop = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+#else
+	m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (pipe(m_stop) != 0)
+		m_stop[0] = m_stop[1] = -1;
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+#ifdef _WIN32
+	for (auto& directory : m_directories)
+	{
+		if (directory->handle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(directory->overlapped.hEvent);
+			CloseHandle(directory->handle);
+		}
+	}
+	if (m_stop)
+		CloseHandle(m_stop);
+#else
+	if (m_inotify != -1)
+		close(m_inotify);
+	for (int fd : m_stop)
+	{
+		if (fd != -1)
+			close(fd);
+	}
+#endif
+}
+
+#ifdef _WIN32
+
+bool FileWatcher::Watch(const std::string& directory)
+{
+	assert(!m_running);
+	auto watched = std::make_unique<Directory>();
+	watched->path = directory;
+	watched->handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+		OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (watched->handle == INVALID_HANDLE_VALUE)
+	{
+		Logger::GetInstance()->Log("Could not watch " + directory);
+		return false;
+	}
+	watched->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	m_directories.push_back(std::move(watched));
+	return true;
+}
+
+bool FileWatcher::Listen(Directory& directory)
+{
+	ResetEvent(directory.overlapped.hEvent);
+	// subdirectories are covered by the one handle
+	return ReadDirectoryChangesW(directory.handle, directory.buffer, sizeof(directory.buffer), TRUE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &directory.overlapped, nullptr);
+}
+
+void FileWatcher::ThreadMain()
+{
+	std::vector<HANDLE> events{ m_stop };
+	// lines up with events after the stop event
+	std::vector<Directory*> listening;
+	for (auto& directory : m_directories)
+	{
+		if (Listen(*directory))
+		{
+			events.push_back(directory->overlapped.hEvent);
+			listening.push_back(directory.get());
+		}
+	}
+
+	while (true)
+	{
+		DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, INFINITE);
+		if (result == WAIT_OBJECT_0 || result == WAIT_FAILED)
+			break;
+
+		Directory& directory = *listening[result - WAIT_OBJECT_0 - 1];
+		DWORD size = 0;
+		// 0 bytes means the buffer overflowed, the changes are lost but the next ones still arrive
+		if (GetOverlappedResult(directory.handle, &directory.overlapped, &size, FALSE) && size)
+		{
+			const char* record = directory.buffer;
+			while (true)
+			{
+				const FILE_NOTIFY_INFORMATION& info = *reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+				if (info.Action == FILE_ACTION_ADDED || info.Action == FILE_ACTION_MODIFIED || info.Action == FILE_ACTION_RENAMED_NEW_NAME)
+				{
+					int length = static_cast<int>(info.FileNameLength / sizeof(WCHAR));
+					int bytes = WideCharToMultiByte(CP_UTF8, 0, info.FileName, length, nullptr, 0, nullptr, nullptr);
+					std::string name(bytes, '\0');
+					WideCharToMultiByte(CP_UTF8, 0, info.FileName, length, name.data(), bytes, nullptr, nullptr);
+					m_onChange(Join(directory.path, name));
+				}
+				if (!info.NextEntryOffset)
+					break;
+				record += info.NextEntryOffset;
+			}
+		}
+		Listen(directory);
+	}
+
+	for (auto& directory : m_directories)
+		CancelIo(directory->handle);
+}
+
+void FileWatcher::Start()
+{
+	if (m_running || !m_stop)
+		return;
+	ResetEvent(m_stop);
+	m_running = true;
+	m_thread = std::thread(&FileWatcher::ThreadMain, this);
+}
+
+void FileWatcher::Stop()
+{
+	if (!m_running)
+		return;
+	SetEvent(m_stop);
+	m_thread.join();
+	m_running = false;
+}
+
+#else
+
+bool FileWatcher::AddWatch(const std::string& path)
+{
+	auto watched = std::make_unique<Directory>();
+	watched->path = path;
+	watched->watch = inotify_add_watch(m_inotify, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watched->watch == -1)
+		return false;
+	m_directories.push_back(std::move(watched));
+	return true;
+}
+
+bool FileWatcher::Watch(const std::string& directory)
+{
+	assert(!m_running);
+	// inotify only covers the one directory, so every subdirectory gets its own watch
+	if (m_inotify == -1 || !AddWatch(directory))
+	{
+		Logger::GetInstance()->Log("Could not watch " + directory);
+		return false;
+	}
+	std::error_code error;
+	for (auto itr = std::filesystem::recursive_directory_iterator(directory, error);
+		itr != std::filesystem::recursive_directory_iterator(); itr.increment(error))
+	{
+		if (itr->is_directory(error))
+			AddWatch(itr->path().generic_string());
+	}
+	return true;
+}
+
+void FileWatcher::ThreadMain()
+{
+	// big enough for a few events with the longest name
+	alignas(inotify_event) char buffer[16 * 1024];
+	pollfd fds[2] = { { m_inotify, POLLIN, 0 }, { m_stop[0], POLLIN, 0 } };
+
+	while (true)
+	{
+		if (poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN))
+			break;
+
+		ssize_t size;
+		while ((size = read(m_inotify, buffer, sizeof(buffer))) > 0)
+		{
+			for (const char* record = buffer; record < buffer + size;)
+			{
+				const inotify_event& event = *reinterpret_cast<const inotify_event*>(record);
+				record += sizeof(inotify_event) + event.len;
+				if (!event.len || (event.mask & IN_ISDIR))
+					continue;
+				for (auto& directory : m_directories)
+				{
+					if (directory->watch == event.wd)
+					{
+						m_onChange(Join(directory->path, event.name));
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+void FileWatcher::Start()
+{
+	if (m_running || m_inotify == -1 || m_stop[0] == -1)
+		return;
+	m_running = true;
+	m_thread = std::thread(&FileWatcher::ThreadMain, this);
+}
+
+void FileWatcher::Stop()
+{
+	if (!m_running)
+		return;
+	char wake = 0;
+	write(m_stop[1], &wake, 1);
+	m_thread.join();
+	m_running = false;
+
+	// the pipe is left empty for the next Start
+	pollfd fd{ m_stop[0], POLLIN, 0 };
+	char drained;
+	while (poll(&fd, 1, 0) > 0 && read(m_stop[0], &drained, 1) > 0);
+}
+
+#endif
+
+bool FileWatcher::IsRunning() const
+{
+	return m_running;
+}
+
+std::string FileWatcher::Normalise(const std::string& path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
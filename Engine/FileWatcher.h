@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace Engine
+{
+	namespace Files
+	{
+		/*
+		reports files that were written to or moved into the watched directories,
+		directory change notifications on Windows and inotify everywhere else
+		onChange is called on the watcher's own thread with the path of the file,
+		built from the watched directory so it can be compared with paths handed out elsewhere
+		one save can be reported more than once since editors often write in steps
+		*/
+		class FileWatcher
+		{
+		public:
+			using Callback = std::function<void(const std::string& path)>;
+
+		private:
+			struct Directory
+			{
+				std::string path;
+#ifdef _WIN32
+				HANDLE handle = INVALID_HANDLE_VALUE;
+				OVERLAPPED overlapped{};
+				// FILE_NOTIFY_INFORMATION records are DWORD aligned
+				alignas(DWORD) char buffer[16 * 1024];
+#else
+				int watch = -1;
+#endif
+			};
+
+			Callback m_onChange;
+			std::vector<std::unique_ptr<Directory>> m_directories;
+			std::thread m_thread;
+			std::atomic<bool> m_running = false;
+#ifdef _WIN32
+			HANDLE m_stop = nullptr;
+
+			bool Listen(Directory& directory);
+#else
+			int m_inotify = -1;
+			// written to to wake the thread up when stopping
+			int m_stop[2] = { -1, -1 };
+
+			bool AddWatch(const std::string& path);
+#endif
+
+			void ThreadMain();
+
+		public:
+			explicit FileWatcher(Callback onChange);
+			~FileWatcher();
+
+			FileWatcher(const FileWatcher&) = delete;
+			FileWatcher& operator=(const FileWatcher&) = delete;
+
+			// watches everything below directory as well, only while stopped
+			// false if the directory could not be watched
+			bool Watch(const std::string& directory);
+
+			void Start();
+			// waits for the thread, no callbacks run after this returns
+			void Stop();
+			bool IsRunning() const;
+
+			// the form paths are reported in, for comparing them with paths from elsewhere
+			static std::string Normalise(const std::string& path);
+		};
+	}
+}
@@ -0,0 +1,143 @@
+#include "FramePacer.h"
+#include <thread>
+#include <cmath>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+using namespace Engine::Time;
+
+namespace
+{
+	// how long before the deadline we stop sleeping and start spinning
+	// covers the default scheduler granularity once timeBeginPeriod(1) is in effect
+	constexpr double SpinThresholdSeconds = 0.002;
+}
+
+FramePacer::FramePacer(double targetFPS, double fixedStep) :
+	m_framePeriod{ 0 },
+	m_fixedStep{ fixedStep },
+	m_spinThreshold{ SpinThresholdSeconds }
+{
+	SetTargetFPS(targetFPS);
+#ifdef _WIN32
+	// bring sleep granularity down from ~15.6ms to 1ms
+	timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FramePacer::SetTargetFPS(double fps)
+{
+	m_framePeriod = fps > 0 ? Duration{ 1.0 / fps } : Duration{ 0 };
+	m_started = false;
+}
+
+void FramePacer::SetFixedTimestep(double seconds)
+{
+	m_fixedStep = Duration{ seconds };
+	m_accumulator = Duration{ 0 };
+}
+
+void FramePacer::SetMaxTicksPerFrame(unsigned ticks)
+{
+	m_maxTicksPerFrame = ticks ? ticks : 1;
+}
+
+void FramePacer::SleepUntil(Clock::time_point deadline) const
+{
+	for (;;)
+	{
+		auto now = Clock::now();
+		if (now >= deadline)
+			return;
+
+		Duration remaining = deadline - now;
+		if (remaining > m_spinThreshold)
+		{
+			std::this_thread::sleep_for(remaining - m_spinThreshold);
+		}
+		else
+		{
+			// short spin for the last stretch, yielding so we
+			// do not starve anything else sharing the core
+			while (Clock::now() < deadline)
+				std::this_thread::yield();
+			return;
+		}
+	}
+}
+
+unsigned FramePacer::BeginFrame()
+{
+	auto now = Clock::now();
+	if (!m_started)
+	{
+		// pretend a single tick has elapsed so the first frame simulates once
+		m_frameStart = now - std::chrono::duration_cast<Clock::duration>(m_fixedStep);
+		m_nextDeadline = now;
+		m_started = true;
+	}
+
+	Duration elapsed = now - m_frameStart;
+	m_frameStart = now;
+	m_accumulator += elapsed;
+
+	unsigned ticks = 0;
+	while (m_accumulator >= m_fixedStep && ticks < m_maxTicksPerFrame)
+	{
+		m_accumulator -= m_fixedStep;
+		++ticks;
+	}
+
+	// we could not keep up, drop the backlog instead of trying to catch up
+	// which would only make the next frame slower
+	if (m_accumulator >= m_fixedStep)
+		m_accumulator = Duration{ std::fmod(m_accumulator.count(), m_fixedStep.count()) };
+
+	m_tick += ticks;
+	m_alpha = static_cast<float>(m_accumulator / m_fixedStep);
+	return ticks;
+}
+
+void FramePacer::EndFrame()
+{
+	if (m_framePeriod.count() <= 0)
+		return;
+
+	auto period = std::chrono::duration_cast<Clock::duration>(m_framePeriod);
+	m_nextDeadline += period;
+
+	auto now = Clock::now();
+	// more than a frame behind, resync rather than rushing the next frames
+	if (now > m_nextDeadline + period)
+	{
+		m_nextDeadline = now;
+		return;
+	}
+	SleepUntil(m_nextDeadline);
+}
+
+float FramePacer::GetFixedTimestep() const
+{
+	return static_cast<float>(m_fixedStep.count());
+}
+
+float FramePacer::GetAlpha() const
+{
+	return m_alpha;
+}
+
+uint64_t FramePacer::GetTick() const
+{
+	return m_tick;
+}
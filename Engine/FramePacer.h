@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+namespace Engine
+{
+	namespace Time
+	{
+		/*
+		paces the main loop on a steady clock
+		the simulation is stepped in fixed ticks out of an accumulator
+		so a slow frame runs several ticks and a fast frame may run none,
+		whatever is left over in the accumulator is exposed as alpha
+		so rendering can interpolate between the last tick and the next one
+		*/
+		class FramePacer
+		{
+		public:
+			using Clock = std::chrono::steady_clock;
+			using Duration = std::chrono::duration<double>;
+
+		private:
+			Clock::time_point m_frameStart;
+			Clock::time_point m_nextDeadline;
+
+			Duration m_framePeriod;
+			Duration m_fixedStep;
+			Duration m_accumulator{ 0 };
+			// anything below this is spun instead of slept
+			// as sleeping is only accurate to the scheduler's granularity
+			Duration m_spinThreshold;
+
+			unsigned m_maxTicksPerFrame = 5;
+			uint64_t m_tick = 0;
+			float m_alpha = 0;
+			bool m_started = false;
+
+			void SleepUntil(Clock::time_point deadline) const;
+
+		public:
+			FramePacer(double targetFPS = 60.0, double fixedStep = 1.0 / 60.0);
+			~FramePacer();
+
+			FramePacer(const FramePacer&) = delete;
+			FramePacer& operator=(const FramePacer&) = delete;
+
+			// 0 removes the frame cap (vsync or the driver will pace instead)
+			void SetTargetFPS(double fps);
+			void SetFixedTimestep(double seconds);
+			// guards against the spiral of death after a long stall
+			void SetMaxTicksPerFrame(unsigned ticks);
+
+			// call at the top of the frame, returns the number of sim ticks to run
+			unsigned BeginFrame();
+			// call at the end of the frame, sleeps until the next frame is due
+			void EndFrame();
+
+			float GetFixedTimestep() const;
+			// fraction of a tick left in the accumulator, in [0, 1)
+			float GetAlpha() const;
+			// total number of ticks simulated so far
+			uint64_t GetTick() const;
+		};
+	}
+}
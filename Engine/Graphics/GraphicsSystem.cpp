@@ -28,3 +28,13 @@ void GraphicsSystem::Exit()
   delete m_gs;
   m_gs = nullptr;
 }
+
+void GraphicsSystem::SetInterpolationAlpha(float alpha)
+{
+  m_interpolationAlpha = alpha;
+}
+
+float GraphicsSystem::GetInterpolationAlpha() const
+{
+  return m_interpolationAlpha;
+}
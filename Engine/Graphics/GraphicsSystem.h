@@ -5,11 +5,17 @@ class GraphicsSystem
 {
 protected:
 	static GraphicsSystem* m_gs;
+
+	// how far between the last sim tick and the next one this frame is
+	float m_interpolationAlpha = 0;
 public:
 	virtual void UpdateBegin() = 0;
 
 	virtual void UpdateEnd(unsigned int flags) = 0;
 
+	void SetInterpolationAlpha(float alpha);
+	float GetInterpolationAlpha() const;
+
 	static GraphicsSystem* GetInstance();
 	static void Exit();
 };
@@ -0,0 +1,54 @@
+#include "DrawQueue.h"
+#include <array>
+
+using namespace Engine::Rendering;
+
+void DrawQueue::Submit(uint64_t key, uint32_t index)
+{
+	m_entries.push_back(Entry{ key, index });
+}
+
+void DrawQueue::Sort()
+{
+	size_t count = m_entries.size();
+	if (count < 2)
+		return;
+
+	// every byte's histogram in one read through the keys
+	std::array<std::array<uint32_t, 256>, 8> histograms{};
+	for (const Entry& entry : m_entries)
+	{
+		for (unsigned byte = 0; byte < 8; ++byte)
+			++histograms[byte][(entry.key >> (byte * 8)) & 0xFF];
+	}
+
+	m_scratch.resize(count);
+	for (unsigned byte = 0; byte < 8; ++byte)
+	{
+		auto& histogram = histograms[byte];
+		// every key has the same value in this byte, the pass would not move anything
+		if (histogram[(m_entries.front().key >> (byte * 8)) & 0xFF] == count)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : histogram)
+		{
+			uint32_t size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+		for (const Entry& entry : m_entries)
+			m_scratch[histogram[(entry.key >> (byte * 8)) & 0xFF]++] = entry;
+		m_entries.swap(m_scratch);
+	}
+}
+
+std::span<const DrawQueue::Entry> DrawQueue::GetEntries() const
+{
+	return m_entries;
+}
+
+void DrawQueue::Clear()
+{
+	m_entries.clear();
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		/*
+		64 bit sort key, from the most significant bits down
+		layer 8 | shader 12 | mesh 12 | texture 16 | depth 16
+		so draws sort by layer first and then by whatever is most expensive to change
+		GL names are masked to fit, two that collide only end up less well grouped
+		*/
+		constexpr uint64_t MakeSortKey(uint8_t layer, uint32_t shader, uint32_t mesh, uint32_t texture, uint16_t depth)
+		{
+			return (uint64_t(layer) << 56) |
+				(uint64_t(shader & 0xFFF) << 44) |
+				(uint64_t(mesh & 0xFFF) << 32) |
+				(uint64_t(texture & 0xFFFF) << 16) |
+				uint64_t(depth);
+		}
+
+		/*
+		collects draws as key and index pairs and sorts them once a frame
+		the sort is an LSD radix sort over the key bytes, bytes every key shares are skipped
+		so a frame with one layer and a handful of shaders only pays for a few passes
+		draws with equal keys stay in the order they were submitted
+		*/
+		class DrawQueue
+		{
+		public:
+			struct Entry
+			{
+				uint64_t key;
+				// whatever the submitter uses to find the draw again
+				uint32_t index;
+			};
+
+		private:
+			std::vector<Entry> m_entries;
+			std::vector<Entry> m_scratch;
+
+		public:
+			void Submit(uint64_t key, uint32_t index);
+			void Sort();
+			// in key order once sorted
+			std::span<const Entry> GetEntries() const;
+			void Clear();
+		};
+	}
+}
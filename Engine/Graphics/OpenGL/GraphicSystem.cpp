@@ -24,6 +24,7 @@ the engine
 #include "glew/wglew.h"
 
 #include "Sprite/Sprite.h"
+#include "Mesh/MeshLoader.h"
 
 
 bool GraphicsSystem_OpenGL::InitializeRenderingEnvironment()
@@ -183,10 +184,18 @@ GraphicsSystem_OpenGL::GraphicsSystem_OpenGL():
 	BindBuffers(*m_debugCircleMesh);
 	BindBuffers(*m_coneMesh);
 
+	{
+		std::lock_guard<std::mutex> lock(m_meshLock);
+		m_meshMap["Square"] = m_squareMesh;
+		m_meshMap["Cone"] = m_coneMesh;
+		m_meshMap["DebugSquare"] = m_debugSquareMesh;
+		m_meshMap["DebugCircle"] = m_debugCircleMesh;
+	}
+
 	//TexMan.LoadAllTexturesFromFile();
 
   auto prog = std::make_shared<ShaderProgram>();
-  prog->Setup();
+  prog->Setup(&ShaderMan.m_programCache);
 	FBOShader.SetProgram(prog);
 
 }
@@ -199,7 +208,6 @@ size_t constexpr indiceCalc(size_t vertexNum, size_t numElePerVertex, size_t ele
 
 void GraphicsSystem_OpenGL::InitVerticesData()
 {
-	m_squareMesh->VAO.m_elementPerVertex = 9;
 	//P0
 	m_squareMesh->VAO.PushVertex(
 		{ -0.5f, -0.5f, 0.5f }, // position
@@ -409,49 +417,63 @@ GLuint GraphicsSystem_OpenGL::GetVAO() const
 	return m_squareMesh->VAOref;
 }
 
+std::shared_ptr<Mesh> GraphicsSystem_OpenGL::GetMesh(const std::string& name) const
+{
+	std::lock_guard<std::mutex> lock(m_meshLock);
+	auto itr = m_meshMap.find(name);
+	if (itr != m_meshMap.end())
+		return itr->second;
+	return {};
+}
+
+std::string GraphicsSystem_OpenGL::GetMeshName(const std::shared_ptr<Mesh>& mesh) const
+{
+	std::lock_guard<std::mutex> lock(m_meshLock);
+	for (auto& [name, ptr] : m_meshMap)
+	{
+		if (ptr == mesh)
+			return name;
+	}
+	return "";
+}
 
-void GraphicsSystem_OpenGL::BindBuffers(const Mesh& mesh)
+std::shared_ptr<Mesh> GraphicsSystem_OpenGL::LoadMesh(const std::string& name, const std::string& path)
 {
-	//can be defined elsewhere
-	GLint numberOfElementsPerPosition = 3;
-	GLint numberOfElementsPerColor = 4;
-	GLint num_Elements_UV = 2;
+	auto mesh = std::make_shared<Mesh>();
+	if (!Engine::Rendering::LoadMeshFile(path, *mesh))
+		return {};
+	std::lock_guard<std::mutex> lock(m_meshLock);
+	m_meshMap[name] = mesh;
+	return mesh;
+}
 
+void GraphicsSystem_OpenGL::BindBuffers(Mesh& mesh)
+{
 	glBindVertexArray(mesh.VAOref);
 
   //VERTICES
   //OpenGL allows to bind to different buffers at the same time as long as they have a different buffer types
   glBindBuffer(GL_ARRAY_BUFFER, mesh.VBOref);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * mesh.VAO.GetNumberVertices() * m_numberOfElementsPerVertex,
-    mesh.VAO.GetVertexArray(), GL_STATIC_DRAW);
+  glBufferData(GL_ARRAY_BUFFER, mesh.VAO.GetSize(), mesh.VAO.GetVertexArray(), GL_STATIC_DRAW);
 
 	//INDICES
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBOref);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.IA.size(),
-		mesh.IA.data(), GL_STATIC_DRAW);
-
-
-	//only position and color
-	glVertexAttribPointer(0, numberOfElementsPerPosition, GL_FLOAT, GL_FALSE,
-		m_numberOfElementsPerVertex * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	GLint stride = numberOfElementsPerPosition;
-	glVertexAttribPointer(1, numberOfElementsPerColor, GL_FLOAT, GL_FALSE,
-		m_numberOfElementsPerVertex * sizeof(GLfloat), (GLvoid*)(stride * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1);
-
-	//
-	stride = numberOfElementsPerColor + numberOfElementsPerPosition;
-	glVertexAttribPointer(2, num_Elements_UV, GL_FLOAT, GL_TRUE,
-		m_numberOfElementsPerVertex * sizeof(GLfloat), (GLvoid*)(stride * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2);
-	/*
-	stride += num_Elements_UV;
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_TRUE,
-		m_numberOfElementsPerVertex * sizeof(GLfloat), (GLvoid*)(stride * sizeof(GLfloat)));
-	glEnableVertexAttribArray(3);
-	*/
+	// half the size whenever the mesh is small enough
+	if (mesh.VAO.GetNumberVertices() <= 0x10000)
+	{
+		std::vector<uint16_t> indices(mesh.IA.begin(), mesh.IA.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * indices.size(), indices.data(), GL_STATIC_DRAW);
+		mesh.indexType = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.IA.size(), mesh.IA.data(), GL_STATIC_DRAW);
+		mesh.indexType = GL_UNSIGNED_INT;
+	}
+	mesh.indexCount = static_cast<GLsizei>(mesh.IA.size());
+
+	// attribute pointers come from the mesh's own layout
+	mesh.VAO.GetLayout().Apply();
 }
 
 void GraphicsSystem_OpenGL::Update()
@@ -463,6 +485,9 @@ void GraphicsSystem_OpenGL::Update()
 
 void GraphicsSystem_OpenGL::UpdateBegin()
 {
+	ShaderMan.FinishPendingShaders();
+	ShaderMan.ApplyShaderChanges();
+
 	//update opengl
 	//if (Input::GetInstance()->IsKeyDown(INF_SPACE))
 	//{
@@ -494,6 +519,16 @@ void GraphicsSystem_OpenGL::UpdateEnd(unsigned int flags)
   }
 }
 
+bool GraphicsSystem_OpenGL::MakeContextCurrent()
+{
+  return wglMakeCurrent(m_windowDC, m_wglDC) == TRUE;
+}
+
+void GraphicsSystem_OpenGL::ReleaseContext()
+{
+  wglMakeCurrent(NULL, NULL);
+}
+
 void GraphicsSystem_OpenGL::SetDebugDrawing()
 {
 	glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
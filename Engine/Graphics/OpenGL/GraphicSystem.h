@@ -27,13 +27,18 @@ This file also holds the declarations for various graphics related Managers
 #include <memory>
 #include <vector>
 #include <future>
+#include <mutex>
+#include <set>
 #include "Shaders/BasicShader.h"
 #include "glew/glew.h"
 #include "glm/glm/glm.hpp"
 #include "Mesh/Mesh.h"
 #include "Shaders/ShaderAttachment.h"
 #include "Shaders/UniformBuffer.h"
+#include "Shaders/UniformArena.h"
+#include "Shaders/ProgramCache.h"
 #include "Graphics/GraphicsSystem.h"
+#include "FileWatcher.h"
 
 #define SWAPBUFFER 1
 
@@ -73,8 +78,6 @@ private:
 
 	void InitVerticesData();
 
-	const GLint m_numberOfElementsPerVertex = { 9 }; //position = (3 floats)   +   4 color + 2 uv + 3 norm = (12 floats)
-
 	BasicShader FBOShader;
 
 	class ShaderManager
@@ -87,10 +90,30 @@ private:
 	private:
 		std::map <ShaderName, ShaderPtr> m_shaderMap;
 		std::map <ShaderPtr, ShaderName> m_reverseMap;
+    // guards both maps, worlds streamed in on worker threads look shaders up by name while they load
+    mutable std::mutex m_shaderLock;
 
     std::map <UniformBuffer::UniformName, std::shared_ptr<UniformBuffer>> m_uniformBufferMap;
 
-    size_t m_NextBindPoint = 0;
+    size_t m_NextBindPoint = Engine::Rendering::FirstSharedBinding;
+
+    Engine::Rendering::ProgramCache m_programCache;
+    // started by LoadShaderNoRet or ReloadShaders and not yet checked
+    std::vector<ShaderProg> m_pendingShaders;
+
+    // every file a shader is built from, normalised the way the watcher reports them
+    std::map<std::string, std::set<ShaderName>> m_dependencies;
+    // guards m_dependencies and m_changedFiles, which the watcher thread reads and writes
+    std::mutex m_changeLock;
+    // read on the watcher thread so the thread drawing only has to compile them
+    std::map<std::string, std::string> m_changedFiles;
+    // rebuilding after a change, swapped in once the driver is done so a frame never waits on them
+    std::vector<ShaderProg> m_reloadingShaders;
+    // last so it is stopped before anything it calls into goes away
+    std::unique_ptr<Engine::Files::FileWatcher> m_watcher;
+
+    void TrackDependencies(const ShaderName& name, const ShaderProg& shader);
+    void OnFileChanged(const std::string& path);
 		ShaderManager() = default;
 		~ShaderManager();
 	public:
@@ -106,18 +129,33 @@ private:
       ShaderName name, 
       std::vector<ShaderAttachment> attachmentList = std::vector<ShaderAttachment>{}); // load a shader from a file
 
+		// only starts the build, the shader can be used once FinishPendingShaders ran
+		// so load them all before waiting on any and the driver builds them side by side
 		void LoadShaderNoRet(Filename vertexSource, Filename fragmentSource,
       ShaderName name, 
       std::vector<ShaderAttachment> attachmentList = std::vector<ShaderAttachment>{}); // load a shader from a file
 		
     void RegisterShader(ShaderPtr shader, ShaderName name);
 		void ReloadShaders();
+		// waits for every shader still being built, UpdateBegin calls it before anything is drawn
+		void FinishPendingShaders();
+
+		// rebuilds only the shaders whose files change below directory, can be called for several directories
+		bool WatchShaders(const std::string& directory);
+		void StopWatchingShaders();
+		// starts rebuilding shaders whose files changed and swaps in the ones that are done,
+		// needs the context, UpdateBegin calls it every frame
+		void ApplyShaderChanges();
 
 		friend class GraphicsSystem_OpenGL;
 	}; 
 
   bool usingDefaultCamera;
   bool enableVsync = true;
+
+	std::map<std::string, std::shared_ptr<Mesh>> m_meshMap;
+	// meshes are looked up by name from worker threads loading snapshots
+	mutable std::mutex m_meshLock;
 public:
 
 	using GSPtr = GraphicsSystem_OpenGL *;
@@ -132,6 +170,14 @@ public:
 	std::shared_ptr<Mesh> m_debugSquareMesh;
 	std::shared_ptr<Mesh> m_debugCircleMesh;
 
+	// built in meshes by name, for anything that has to refer to a mesh
+	// outside of this process such as world snapshots
+	std::shared_ptr<Mesh> GetMesh(const std::string& name) const;
+	std::string GetMeshName(const std::shared_ptr<Mesh>& mesh) const;
+	// maps a .emesh file from the mesh compiler and registers it under name, nullptr if it could not be loaded
+	// needs the context, so once the render thread runs it goes through RenderThread::Enqueue and Flush
+	std::shared_ptr<Mesh> LoadMesh(const std::string& name, const std::string& path);
+
   //=======  type aliases  ========
 	using ShaderName = ShaderManager::ShaderName;
   using ShaderPtr = ShaderManager::ShaderPtr;
@@ -152,12 +198,18 @@ public:
 
 	void Update();
 
-	void BindBuffers(const Mesh& mesh);
+	// uploads the mesh and sets its attributes up from its vertex layout
+	void BindBuffers(Mesh& mesh);
 
 	void UpdateBegin();
 
 	void UpdateEnd(unsigned int flags = SWAPBUFFER);
 
+  // the context is only current on one thread at a time,
+  // the render thread takes it over while it is running
+  bool MakeContextCurrent();
+  void ReleaseContext();
+
 	void SetDebugDrawing();
 	void SetStandardDrawing();
 
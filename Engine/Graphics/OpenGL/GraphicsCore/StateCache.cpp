@@ -0,0 +1,105 @@
+#include "StateCache.h"
+
+using namespace Engine::Rendering;
+
+StateCache::StateCache()
+{
+	Invalidate();
+}
+
+bool StateCache::UseProgram(GLuint program)
+{
+	if (m_program == program)
+	{
+		++m_skipped;
+		return false;
+	}
+	glUseProgram(program);
+	m_program = program;
+	++m_issued;
+	return true;
+}
+
+bool StateCache::BindVertexArray(GLuint vertexArray)
+{
+	if (m_vertexArray == vertexArray)
+	{
+		++m_skipped;
+		return false;
+	}
+	glBindVertexArray(vertexArray);
+	m_vertexArray = vertexArray;
+	++m_issued;
+	return true;
+}
+
+bool StateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+	// only the array buffer is cached, uniform buffers are bound by glBindBufferRange
+	// and by UniformBuffer directly, which would leave a cached value stale
+	GLuint* bound = nullptr;
+	if (target == GL_ARRAY_BUFFER)
+		bound = &m_arrayBuffer;
+
+	if (bound && *bound == buffer)
+	{
+		++m_skipped;
+		return false;
+	}
+	glBindBuffer(target, buffer);
+	if (bound)
+		*bound = buffer;
+	++m_issued;
+	return true;
+}
+
+bool StateCache::BindTexture(unsigned unit, GLuint texture)
+{
+	if (unit >= TextureUnits)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		m_activeUnit = Unknown;
+		++m_issued;
+		return true;
+	}
+	if (m_textures[unit] == texture)
+	{
+		++m_skipped;
+		return false;
+	}
+	if (m_activeUnit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeUnit = unit;
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	m_textures[unit] = texture;
+	++m_issued;
+	return true;
+}
+
+void StateCache::Invalidate()
+{
+	m_program = Unknown;
+	m_vertexArray = Unknown;
+	m_arrayBuffer = Unknown;
+	m_activeUnit = Unknown;
+	m_textures.fill(Unknown);
+}
+
+uint64_t StateCache::GetIssuedCount() const
+{
+	return m_issued;
+}
+
+uint64_t StateCache::GetSkippedCount() const
+{
+	return m_skipped;
+}
+
+void StateCache::ResetCounts()
+{
+	m_issued = 0;
+	m_skipped = 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#define GLEW_STATIC
+#include "glew/glew.h"
+#include <array>
+#include <cstdint>
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		/*
+		remembers what is bound so binding it again is skipped
+		only sees binds made through it, so Invalidate has to be called
+		whenever anything else may have touched GL, e.g. at the start of a frame
+		the element buffer belongs to the vertex array so it is never cached,
+		other buffer targets go straight through too
+		*/
+		class StateCache
+		{
+		public:
+			static constexpr unsigned TextureUnits = 16;
+
+		private:
+			static constexpr GLuint Unknown = ~GLuint(0);
+
+			GLuint m_program = Unknown;
+			GLuint m_vertexArray = Unknown;
+			GLuint m_arrayBuffer = Unknown;
+			GLuint m_activeUnit = Unknown;
+			std::array<GLuint, TextureUnits> m_textures;
+
+			// binds that were actually made and ones that were skipped since the last reset
+			uint64_t m_issued = 0;
+			uint64_t m_skipped = 0;
+
+		public:
+			StateCache();
+
+			// the functions return true if the binding changed
+			bool UseProgram(GLuint program);
+			bool BindVertexArray(GLuint vertexArray);
+			bool BindBuffer(GLenum target, GLuint buffer);
+			bool BindTexture(unsigned unit, GLuint texture);
+
+			// forget everything, the next bind of each kind always goes through
+			void Invalidate();
+
+			uint64_t GetIssuedCount() const;
+			uint64_t GetSkippedCount() const;
+			void ResetCounts();
+		};
+	}
+}
@@ -0,0 +1,175 @@
+#include "StreamBuffer.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <string>
+
+using namespace Engine::Rendering;
+
+namespace
+{
+	// nothing smaller is worth creating
+	constexpr size_t MinimumRegionSize = 64 * 1024;
+	constexpr GLuint64 FenceTimeout = 1000000;
+	// the most GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT is in practice, used if the query fails
+	constexpr size_t DefaultRegionAlignment = 256;
+
+	// binding to the copy target leaves every binding draws care about alone
+	constexpr GLenum StreamTarget = GL_COPY_WRITE_BUFFER;
+}
+
+void StreamBuffer::Create(size_t regionSize)
+{
+	Release();
+
+	// every region has to start where a uniform block can be bound, not just the first
+	GLint uniformAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	m_regionAlignment = std::max(static_cast<size_t>(std::max(uniformAlignment, 0)), DefaultRegionAlignment);
+	m_regionSize = std::max(regionSize, MinimumRegionSize);
+	m_regionSize = (m_regionSize + m_regionAlignment - 1) / m_regionAlignment * m_regionAlignment;
+	m_persistent = GLEW_ARB_buffer_storage;
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(StreamTarget, m_buffer);
+
+	size_t size = m_regionSize * RegionCount;
+	if (m_persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(StreamTarget, size, nullptr, flags);
+		m_mapped = static_cast<uint8_t*>(glMapBufferRange(StreamTarget, 0, size, flags));
+		if (!m_mapped)
+		{
+			Logger::GetInstance()->Log("Stream buffer could not be mapped persistently, falling back to orphaning");
+			glDeleteBuffers(1, &m_buffer);
+			glGenBuffers(1, &m_buffer);
+			glBindBuffer(StreamTarget, m_buffer);
+			m_persistent = false;
+		}
+	}
+	if (!m_persistent)
+		glBufferData(StreamTarget, m_regionSize, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(StreamTarget, 0);
+}
+
+void StreamBuffer::WaitFor(unsigned region)
+{
+	GLsync& fence = m_fences[region];
+	if (!fence)
+		return;
+
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true)
+	{
+		GLenum result = glClientWaitSync(fence, flags, FenceTimeout);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+		// the flush only has to happen once
+		flags = 0;
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void StreamBuffer::BeginFrame(size_t minimumSize)
+{
+	assert(!m_writing);
+	if (!m_buffer || m_regionSize < minimumSize)
+	{
+		// grows by at least double so a growing scene settles quickly
+		size_t size = std::max(minimumSize, m_regionSize * 2);
+		Create(size);
+		Logger::GetInstance()->Log("Stream buffer regions grown to " + std::to_string(m_regionSize) + " bytes");
+	}
+
+	m_region = (m_region + 1) % RegionCount;
+	m_used = 0;
+	m_writing = true;
+
+	if (m_persistent)
+	{
+		WaitFor(m_region);
+		return;
+	}
+
+	// the driver hands out fresh memory instead of waiting for draws still reading the old one
+	glBindBuffer(StreamTarget, m_buffer);
+	glBufferData(StreamTarget, m_regionSize, nullptr, GL_STREAM_DRAW);
+	m_mapped = static_cast<uint8_t*>(glMapBufferRange(StreamTarget, 0, m_regionSize,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	glBindBuffer(StreamTarget, 0);
+}
+
+StreamBuffer::Allocation StreamBuffer::Allocate(size_t size, size_t alignment)
+{
+	assert(m_writing);
+	// orphaned buffers only ever hold the one region
+	size_t base = m_persistent ? m_region * m_regionSize : 0;
+	assert(base % m_regionAlignment == 0);
+
+	// the offset into the whole buffer is what gets bound, so that is what has to be aligned
+	size_t start = (base + m_used + alignment - 1) / alignment * alignment - base;
+	if (!m_mapped || start + size > m_regionSize)
+		return {};
+	m_used = start + size;
+	return Allocation{ m_mapped + base + start, static_cast<GLintptr>(base + start) };
+}
+
+void StreamBuffer::Commit()
+{
+	if (!m_writing)
+		return;
+	m_writing = false;
+
+	if (!m_persistent && m_mapped)
+	{
+		glBindBuffer(StreamTarget, m_buffer);
+		glUnmapBuffer(StreamTarget);
+		glBindBuffer(StreamTarget, 0);
+		m_mapped = nullptr;
+	}
+}
+
+void StreamBuffer::EndFrame()
+{
+	Commit();
+	if (m_persistent)
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint StreamBuffer::GetBuffer() const
+{
+	return m_buffer;
+}
+
+size_t StreamBuffer::GetRegionSize() const
+{
+	return m_regionSize;
+}
+
+bool StreamBuffer::IsPersistent() const
+{
+	return m_persistent;
+}
+
+void StreamBuffer::Release()
+{
+	for (unsigned region = 0; region < RegionCount; ++region)
+		WaitFor(region);
+
+	if (m_buffer)
+	{
+		if (m_mapped)
+		{
+			glBindBuffer(StreamTarget, m_buffer);
+			glUnmapBuffer(StreamTarget);
+			glBindBuffer(StreamTarget, 0);
+		}
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_mapped = nullptr;
+	m_regionSize = 0;
+	m_used = 0;
+	m_writing = false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#define GLEW_STATIC
+#include "glew/glew.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		/*
+		one buffer for everything that is rewritten every frame, split into regions
+		that are used in turn, a region is only written again once the fence placed
+		after the frame that last used it has signalled, so the GPU is never waited on
+		unless it is a whole ring behind
+		with glBufferStorage the buffer stays mapped for its whole life,
+		without it each frame orphans the region and maps it again
+		the buffer has no fixed target, bind GetBuffer() to whatever the data is used as
+		*/
+		class StreamBuffer
+		{
+		public:
+			static constexpr unsigned RegionCount = 3;
+
+			struct Allocation
+			{
+				// null if the region is full
+				void* data = nullptr;
+				// from the start of the buffer, for glVertexAttribPointer, glBindBufferRange and the like
+				GLintptr offset = 0;
+			};
+
+		private:
+			GLuint m_buffer = 0;
+			size_t m_regionSize = 0;
+			// regions start on multiples of this
+			size_t m_regionAlignment = 1;
+			bool m_persistent = false;
+			// whole buffer when persistent, the current region otherwise
+			uint8_t* m_mapped = nullptr;
+
+			unsigned m_region = 0;
+			size_t m_used = 0;
+			bool m_writing = false;
+			std::array<GLsync, RegionCount> m_fences{};
+
+			void Create(size_t regionSize);
+			void WaitFor(unsigned region);
+
+		public:
+			StreamBuffer() = default;
+			StreamBuffer(const StreamBuffer&) = delete;
+			StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+			// moves on to the next region, it is recreated first if it is smaller than minimumSize
+			void BeginFrame(size_t minimumSize);
+			// space for size bytes in this frame's region, offset from the start of the buffer is a multiple of alignment
+			Allocation Allocate(size_t size, size_t alignment = 16);
+			// everything has been written, the region can be drawn from after this
+			void Commit();
+			// fences the region once the frame's draws have been issued
+			void EndFrame();
+
+			GLuint GetBuffer() const;
+			size_t GetRegionSize() const;
+			bool IsPersistent() const;
+
+			// needs the context to be current
+			void Release();
+		};
+	}
+}
@@ -16,49 +16,62 @@ VertexArrayObject is used to build basic meshes
 #include "VertexArrayObject.h"
 #include <cassert>
 
+using namespace Engine::Rendering;
+
 VertexArrayObject::VertexArrayObject() : 
   m_numVertices{ 0 },
-  m_elementPerVertex{ 0 }
+  m_layout{ VertexLayout::Compact() }
 {
 }
 
-void VertexArrayObject::PushValue(float num)
+void VertexArrayObject::SetLayout(VertexLayout layout)
 {
-  m_elementArray.push_back(num);//position
+  assert(m_vertexData.empty());
+  m_layout = std::move(layout);
+}
+
+const VertexLayout& VertexArrayObject::GetLayout() const
+{
+  return m_layout;
 }
 
 void VertexArrayObject::PushVertex(glm::vec3 pos, glm::vec4 color, glm::vec3 uv, glm::vec3 norm)
 {
-  m_elementArray.push_back(pos.x);//position
-  m_elementArray.push_back(pos.y);//position
-  m_elementArray.push_back(pos.z);//position
-  m_elementArray.push_back(color[0]);//color
-  m_elementArray.push_back(color[1]);//color
-  m_elementArray.push_back(color[2]);//color
-  m_elementArray.push_back(color[3]);//color
-  m_elementArray.push_back(uv.x);//u
-  m_elementArray.push_back(uv.y);//v
-  //m_elementArray.push_back(norm.x);//position
-  //m_elementArray.push_back(norm.y);//position
-  //m_elementArray.push_back(norm.z);//position
+  size_t start = m_vertexData.size();
+  m_vertexData.resize(start + m_layout.GetStride());
+  uint8_t* vertex = m_vertexData.data() + start;
+
+  for (const VertexAttribute& attribute : m_layout.GetAttributes())
+  {
+    glm::vec4 value;
+    switch (attribute.semantic)
+    {
+    case VertexSemantic::Position: value = glm::vec4(pos, 1.f); break;
+    case VertexSemantic::Color: value = color; break;
+    case VertexSemantic::TexCoord: value = glm::vec4(uv, 0.f); break;
+    case VertexSemantic::Normal: value = glm::vec4(norm, 0.f); break;
+    }
+    WriteAttribute(vertex + attribute.offset, attribute.format, value);
+  }
   ++m_numVertices;
 }
 
 void VertexArrayObject::Clear()
 {
-  m_elementArray.clear();
+  m_vertexData.clear();
+  m_numVertices = 0;
 }
 
-void VertexArrayObject::SetNumberVertices(uint16_t numVertices) 
+void VertexArrayObject::SetNumberVertices(unsigned int numVertices) 
 {
-  assert(numVertices < m_elementArray.size());
+  assert(size_t(numVertices) * m_layout.GetStride() <= m_vertexData.size());
 
   m_numVertices = numVertices;
 }
 
 size_t VertexArrayObject::GetSize() const
 {
-  return m_elementArray.size();
+  return m_vertexData.size();
 }
 
 unsigned int VertexArrayObject::GetNumberVertices() const
@@ -66,8 +79,8 @@ unsigned int VertexArrayObject::GetNumberVertices() const
   return m_numVertices;
 }
 
-const float* VertexArrayObject::GetVertexArray() const
+const uint8_t* VertexArrayObject::GetVertexArray() const
 {
-  return m_elementArray.data();
+  return m_vertexData.data();
 }
 
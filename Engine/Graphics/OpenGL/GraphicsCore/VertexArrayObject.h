@@ -18,27 +18,33 @@ VertexArrayObject is used to build basic meshes
 
 #include "glew/glew.h"
 #include "glm/glm/glm.hpp"
+#include "VertexLayout.h"
 
 class VertexArrayObject
 {
-  uint16_t m_numVertices;
+  unsigned int m_numVertices;
+  Engine::Rendering::VertexLayout m_layout;
 public:
-  std::vector<float> m_elementArray;
+  // packed the way m_layout describes
+  std::vector<uint8_t> m_vertexData;
   VertexArrayObject();
-  uint16_t m_elementPerVertex;
- 
-  void PushValue(float num);
 
+  // only while there are no vertices
+  void SetLayout(Engine::Rendering::VertexLayout layout);
+  const Engine::Rendering::VertexLayout& GetLayout() const;
+
+  // attributes the layout does not have are left out
   void PushVertex(glm::vec3 pos, glm::vec4 color, glm::vec3 uv, glm::vec3 norm);
 
   void Clear();
 
-  void SetNumberVertices(uint16_t numVertices);
+  void SetNumberVertices(unsigned int numVertices);
 
+  // in bytes
   size_t GetSize() const;
   unsigned int GetNumberVertices() const;
 
-  const float* GetVertexArray() const;
+  const uint8_t* GetVertexArray() const;
 
 };
 
@@ -0,0 +1,157 @@
+#include "VertexLayout.h"
+#include "glm/glm/packing.hpp"
+#include "glm/glm/gtc/packing.hpp"
+#include <cstring>
+
+using namespace Engine::Rendering;
+
+namespace
+{
+	struct FormatInfo
+	{
+		GLint components;
+		GLenum type;
+		GLboolean normalized;
+		uint16_t size;
+	};
+
+	FormatInfo GetFormatInfo(VertexFormat format)
+	{
+		switch (format)
+		{
+		case VertexFormat::Float2: return { 2, GL_FLOAT, GL_FALSE, 8 };
+		case VertexFormat::Float3: return { 3, GL_FLOAT, GL_FALSE, 12 };
+		case VertexFormat::Float4: return { 4, GL_FLOAT, GL_FALSE, 16 };
+		case VertexFormat::Half2: return { 2, GL_HALF_FLOAT, GL_FALSE, 4 };
+		case VertexFormat::Half4: return { 4, GL_HALF_FLOAT, GL_FALSE, 8 };
+		case VertexFormat::UNorm8x4: return { 4, GL_UNSIGNED_BYTE, GL_TRUE, 4 };
+		case VertexFormat::UNorm16x2: return { 2, GL_UNSIGNED_SHORT, GL_TRUE, 4 };
+		case VertexFormat::SNorm10x3_2: return { 4, GL_INT_2_10_10_10_REV, GL_TRUE, 4 };
+		}
+		return { 0, GL_FLOAT, GL_FALSE, 0 };
+	}
+}
+
+uint16_t Engine::Rendering::GetFormatSize(VertexFormat format)
+{
+	return GetFormatInfo(format).size;
+}
+
+void Engine::Rendering::WriteAttribute(uint8_t* dest, VertexFormat format, const glm::vec4& value)
+{
+	switch (format)
+	{
+	case VertexFormat::Float2:
+	case VertexFormat::Float3:
+	case VertexFormat::Float4:
+		std::memcpy(dest, &value[0], GetFormatSize(format));
+		break;
+	case VertexFormat::Half2:
+	{
+		glm::uint packed = glm::packHalf2x16(glm::vec2(value));
+		std::memcpy(dest, &packed, sizeof(packed));
+		break;
+	}
+	case VertexFormat::Half4:
+	{
+		glm::uint64 packed = glm::packHalf4x16(value);
+		std::memcpy(dest, &packed, sizeof(packed));
+		break;
+	}
+	case VertexFormat::UNorm8x4:
+	{
+		glm::uint packed = glm::packUnorm4x8(value);
+		std::memcpy(dest, &packed, sizeof(packed));
+		break;
+	}
+	case VertexFormat::UNorm16x2:
+	{
+		glm::uint packed = glm::packUnorm2x16(glm::vec2(value));
+		std::memcpy(dest, &packed, sizeof(packed));
+		break;
+	}
+	case VertexFormat::SNorm10x3_2:
+	{
+		glm::uint32 packed = glm::packSnorm3x10_1x2(value);
+		std::memcpy(dest, &packed, sizeof(packed));
+		break;
+	}
+	}
+}
+
+VertexLayout& VertexLayout::Add(VertexSemantic semantic, VertexFormat format, GLuint location)
+{
+	m_attributes.push_back(VertexAttribute{ semantic, format, location, m_stride });
+	m_stride += GetFormatSize(format);
+	return *this;
+}
+
+VertexLayout VertexLayout::Compact()
+{
+	VertexLayout layout;
+	layout.Add(VertexSemantic::Position, VertexFormat::Half4, PositionLocation)
+		.Add(VertexSemantic::Color, VertexFormat::UNorm8x4, ColorLocation)
+		.Add(VertexSemantic::TexCoord, VertexFormat::Half2, TexCoordLocation);
+	return layout;
+}
+
+VertexLayout VertexLayout::CompactWithNormal()
+{
+	VertexLayout layout = Compact();
+	layout.Add(VertexSemantic::Normal, VertexFormat::SNorm10x3_2, NormalLocation);
+	return layout;
+}
+
+VertexLayout VertexLayout::Full()
+{
+	VertexLayout layout;
+	layout.Add(VertexSemantic::Position, VertexFormat::Float3, PositionLocation)
+		.Add(VertexSemantic::Color, VertexFormat::Float4, ColorLocation)
+		.Add(VertexSemantic::TexCoord, VertexFormat::Float2, TexCoordLocation);
+	return layout;
+}
+
+uint16_t VertexLayout::GetStride() const
+{
+	return m_stride;
+}
+
+const std::vector<VertexAttribute>& VertexLayout::GetAttributes() const
+{
+	return m_attributes;
+}
+
+const VertexAttribute* VertexLayout::Find(VertexSemantic semantic) const
+{
+	for (auto& attribute : m_attributes)
+	{
+		if (attribute.semantic == semantic)
+			return &attribute;
+	}
+	return nullptr;
+}
+
+void VertexLayout::Apply() const
+{
+	for (auto& attribute : m_attributes)
+	{
+		FormatInfo info = GetFormatInfo(attribute.format);
+		glVertexAttribPointer(attribute.location, info.components, info.type, info.normalized,
+			m_stride, (GLvoid*)(uintptr_t)attribute.offset);
+		glEnableVertexAttribArray(attribute.location);
+	}
+}
+
+bool VertexLayout::operator==(const VertexLayout& rhs) const
+{
+	if (m_stride != rhs.m_stride || m_attributes.size() != rhs.m_attributes.size())
+		return false;
+	for (size_t i = 0; i < m_attributes.size(); ++i)
+	{
+		const VertexAttribute& a = m_attributes[i];
+		const VertexAttribute& b = rhs.m_attributes[i];
+		if (a.semantic != b.semantic || a.format != b.format || a.location != b.location || a.offset != b.offset)
+			return false;
+	}
+	return true;
+}
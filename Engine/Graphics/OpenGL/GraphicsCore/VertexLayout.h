@@ -0,0 +1,89 @@
+#pragma once
+#define GLEW_STATIC
+#include "glew/glew.h"
+#include "glm/glm/glm.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		// how one attribute is stored, everything is a multiple of 4 bytes so attributes stay aligned
+		enum class VertexFormat : uint8_t
+		{
+			Float2,
+			Float3,
+			Float4,
+			// 16 bit floats, positions and uvs of small meshes barely lose anything
+			Half2,
+			Half4,
+			// 0 to 1 in 8 bits, colours
+			UNorm8x4,
+			// 0 to 1 in 16 bits, uvs that need more range than halves
+			UNorm16x2,
+			// -1 to 1 in 10 bits for xyz and 2 for w, normals and tangents
+			SNorm10x3_2
+		};
+
+		// what PushVertex fills the attribute with
+		enum class VertexSemantic : uint8_t
+		{
+			Position,
+			Color,
+			TexCoord,
+			Normal
+		};
+
+		struct VertexAttribute
+		{
+			VertexSemantic semantic;
+			VertexFormat format;
+			GLuint location;
+			uint16_t offset;
+		};
+
+		// bytes a format takes
+		uint16_t GetFormatSize(VertexFormat format);
+
+		// packs value into dest in format, components the format lacks are dropped
+		void WriteAttribute(uint8_t* dest, VertexFormat format, const glm::vec4& value);
+
+		/*
+		describes the vertices of a mesh, attributes are laid out one after another
+		in the order they are added, Apply points the bound vertex array at them
+		the shader side does not change, packed attributes arrive as floats
+		*/
+		class VertexLayout
+		{
+			std::vector<VertexAttribute> m_attributes;
+			uint16_t m_stride = 0;
+
+		public:
+			// the attribute locations every mesh shader uses
+			static constexpr GLuint PositionLocation = 0;
+			static constexpr GLuint ColorLocation = 1;
+			static constexpr GLuint TexCoordLocation = 2;
+			// 3 to 7 are taken by sprite instances
+			static constexpr GLuint NormalLocation = 8;
+
+			VertexLayout& Add(VertexSemantic semantic, VertexFormat format, GLuint location);
+
+			// half positions, 8 bit colour and half uvs, 16 bytes a vertex
+			static VertexLayout Compact();
+			// compact with a packed normal, 20 bytes a vertex
+			static VertexLayout CompactWithNormal();
+			// full floats for meshes too large for halves, 36 bytes a vertex
+			static VertexLayout Full();
+
+			uint16_t GetStride() const;
+			const std::vector<VertexAttribute>& GetAttributes() const;
+			const VertexAttribute* Find(VertexSemantic semantic) const;
+
+			// needs the vertex array and its vertex buffer to be bound
+			void Apply() const;
+
+			bool operator==(const VertexLayout& rhs) const;
+		};
+	}
+}
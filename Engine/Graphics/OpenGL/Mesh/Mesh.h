@@ -24,6 +24,10 @@ struct Mesh
   GLuint VBOref;
   GLuint EBOref;
   GLenum drawMode;
+  // set when the buffers are filled, 16 bit whenever every vertex can be reached with them
+  GLenum indexType = GL_UNSIGNED_INT;
+  // what is drawn, IA is empty for meshes loaded from a file
+  GLsizei indexCount = 0;
   void Clear();
   Mesh() = default;
 };
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "MeshCompiler.h"
+#include "MeshFile.h"
+#include "../GraphicsCore/VertexArrayObject.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+
+using namespace Engine::Rendering;
+
+namespace
+{
+	// half floats keep 11 significant bits, so rounding is off by at most this much of the value
+	constexpr float HalfRelativeError = 1.f / 2048.f;
+
+	// scores from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float ValenceBoostScale = 2.f;
+	constexpr float ValenceBoostPower = 0.5f;
+
+	VertexLayout ChooseLayout(const MeshSource& source, const MeshCompileOptions& options, glm::vec3 boundsMin, glm::vec3 boundsMax)
+	{
+		glm::vec3 extent = glm::max(glm::abs(boundsMin), glm::abs(boundsMax));
+		float largest = std::max({ extent.x, extent.y, extent.z });
+		bool halfPositions = largest * HalfRelativeError <= options.positionTolerance;
+
+		// uvs that stay inside the texture get 16 bits of fixed point instead of a half's 11
+		bool unitTexCoords = std::all_of(source.texCoords.begin(), source.texCoords.end(), [](const glm::vec2& uv)
+			{
+				return uv.x >= 0.f && uv.x <= 1.f && uv.y >= 0.f && uv.y <= 1.f;
+			});
+
+		VertexLayout layout;
+		layout.Add(VertexSemantic::Position, halfPositions ? VertexFormat::Half4 : VertexFormat::Float3, VertexLayout::PositionLocation)
+			// always there, shaders multiply by it
+			.Add(VertexSemantic::Color, VertexFormat::UNorm8x4, VertexLayout::ColorLocation)
+			.Add(VertexSemantic::TexCoord, unitTexCoords ? VertexFormat::UNorm16x2 : VertexFormat::Half2, VertexLayout::TexCoordLocation);
+		if (!source.normals.empty())
+			layout.Add(VertexSemantic::Normal, VertexFormat::SNorm10x3_2, VertexLayout::NormalLocation);
+		return layout;
+	}
+
+	float ScoreVertex(int cachePosition, uint32_t remaining, unsigned cacheSize)
+	{
+		// nothing left to draw with it
+		if (!remaining)
+			return -1.f;
+
+		float score = 0.f;
+		if (cachePosition >= 0)
+		{
+			// the last triangle's vertices score lower so the next one is not always a neighbour of the same edge
+			if (cachePosition < 3)
+				score = LastTriangleScore;
+			else
+				score = std::pow(1.f - float(cachePosition - 3) / float(cacheSize - 3), CacheDecayPower);
+		}
+		// vertices with few triangles left are finished off before they leave the cache
+		return score + ValenceBoostScale * std::pow(float(remaining), -ValenceBoostPower);
+	}
+
+	size_t Align(size_t offset)
+	{
+		return (offset + MeshFileAlignment - 1) / MeshFileAlignment * MeshFileAlignment;
+	}
+}
+
+float Engine::Rendering::GetACMR(const std::vector<uint32_t>& indices, unsigned vertexCount, unsigned cacheSize)
+{
+	if (indices.size() < 3)
+		return 0.f;
+
+	// the time each vertex last entered the cache, it is still in it if that was less than cacheSize misses ago
+	std::vector<size_t> entered(vertexCount, 0);
+	size_t misses = 0;
+	for (uint32_t index : indices)
+	{
+		if (!entered[index] || misses - entered[index] >= cacheSize)
+			entered[index] = ++misses;
+	}
+	return float(misses) / float(indices.size() / 3);
+}
+
+std::vector<uint32_t> Engine::Rendering::OptimiseVertexCache(const std::vector<uint32_t>& indices, unsigned vertexCount, unsigned cacheSize)
+{
+	size_t triangleCount = indices.size() / 3;
+	cacheSize = std::max(cacheSize, 4u);
+
+	// triangles still to be drawn that use each vertex, packed into one array
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		++remaining[indices[i]];
+	std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+	std::partial_sum(remaining.begin(), remaining.end(), firstTriangle.begin() + 1);
+	std::vector<uint32_t> triangles(firstTriangle.back());
+	{
+		std::vector<uint32_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (unsigned v = 0; v < vertexCount; ++v)
+		vertexScore[v] = ScoreVertex(-1, remaining[v], cacheSize);
+
+	auto scoreTriangle = [&](size_t t)
+	{
+		return vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+	};
+
+	// starts on the triangle with the loneliest vertices
+	int64_t best = -1;
+	float bestScore = -1.f;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		float score = scoreTriangle(t);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = static_cast<int64_t>(t);
+		}
+	}
+	std::vector<bool> emitted(triangleCount, false);
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(cacheSize + 3);
+	nextCache.reserve(cacheSize + 3);
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+
+	// where to look for a triangle when nothing in the cache has one left
+	size_t scan = 0;
+	while (result.size() < triangleCount * 3)
+	{
+		if (best < 0)
+		{
+			while (emitted[scan])
+				++scan;
+			best = static_cast<int64_t>(scan);
+		}
+
+		const uint32_t* triangle = &indices[best * 3];
+		emitted[best] = true;
+		result.insert(result.end(), triangle, triangle + 3);
+
+		for (int corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = triangle[corner];
+			uint32_t* begin = &triangles[firstTriangle[vertex]];
+			uint32_t* end = begin + remaining[vertex];
+			*std::find(begin, end, static_cast<uint32_t>(best)) = *(end - 1);
+			--remaining[vertex];
+		}
+
+		// the triangle's vertices move to the front, everything else shifts back
+		nextCache.assign(triangle, triangle + 3);
+		for (uint32_t vertex : cache)
+		{
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				nextCache.push_back(vertex);
+		}
+		for (size_t i = 0; i < nextCache.size(); ++i)
+		{
+			uint32_t vertex = nextCache[i];
+			cachePosition[vertex] = i < cacheSize ? static_cast<int>(i) : -1;
+			vertexScore[vertex] = ScoreVertex(cachePosition[vertex], remaining[vertex], cacheSize);
+		}
+
+		// only triangles touching the cache changed, the best of them goes next
+		best = -1;
+		bestScore = -1.f;
+		for (uint32_t vertex : nextCache)
+		{
+			uint32_t* begin = &triangles[firstTriangle[vertex]];
+			for (uint32_t* t = begin; t != begin + remaining[vertex]; ++t)
+			{
+				float score = scoreTriangle(*t);
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = *t;
+				}
+			}
+		}
+
+		if (nextCache.size() > cacheSize)
+			nextCache.resize(cacheSize);
+		std::swap(cache, nextCache);
+	}
+
+	// anything past the last whole triangle is kept as it was
+	result.insert(result.end(), indices.begin() + triangleCount * 3, indices.end());
+	return result;
+}
+
+std::vector<uint32_t> Engine::Rendering::OptimiseVertexFetch(std::vector<uint32_t>& indices, unsigned vertexCount)
+{
+	std::vector<uint32_t> remap(vertexCount, UnusedVertex);
+	uint32_t next = 0;
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == UnusedVertex)
+			remap[index] = next++;
+		index = remap[index];
+	}
+	return remap;
+}
+
+CompiledMesh Engine::Rendering::CompileMesh(const MeshSource& source, const MeshCompileOptions& options)
+{
+	CompiledMesh mesh;
+	mesh.drawMode = source.drawMode;
+	if (source.positions.empty())
+		return mesh;
+
+	mesh.boundsMin = mesh.boundsMax = source.positions.front();
+	for (const glm::vec3& position : source.positions)
+	{
+		mesh.boundsMin = glm::min(mesh.boundsMin, position);
+		mesh.boundsMax = glm::max(mesh.boundsMax, position);
+	}
+	mesh.layout = ChooseLayout(source, options, mesh.boundsMin, mesh.boundsMax);
+
+	// the vertex array object packs exactly the way the runtime does
+	VertexArrayObject packer;
+	packer.SetLayout(mesh.layout);
+	for (size_t i = 0; i < source.positions.size(); ++i)
+	{
+		packer.PushVertex(source.positions[i],
+			i < source.colors.size() ? source.colors[i] : glm::vec4(1.f),
+			i < source.texCoords.size() ? glm::vec3(source.texCoords[i], 0.f) : glm::vec3(0.f),
+			i < source.normals.size() ? source.normals[i] : glm::vec3(0.f));
+	}
+
+	// vertices that only differed below the quantization are merged
+	size_t stride = mesh.layout.GetStride();
+	const uint8_t* packed = packer.GetVertexArray();
+	std::unordered_map<std::string_view, uint32_t> welded;
+	welded.reserve(source.positions.size());
+	std::vector<uint32_t> weldRemap(source.positions.size());
+	for (size_t i = 0; i < source.positions.size(); ++i)
+	{
+		std::string_view key(reinterpret_cast<const char*>(packed + i * stride), stride);
+		auto [itr, inserted] = welded.emplace(key, static_cast<uint32_t>(welded.size()));
+		if (inserted)
+			mesh.vertices.insert(mesh.vertices.end(), packed + i * stride, packed + (i + 1) * stride);
+		weldRemap[i] = itr->second;
+	}
+	mesh.vertexCount = static_cast<unsigned>(welded.size());
+
+	if (source.indices.empty())
+	{
+		mesh.indices.resize(source.positions.size());
+		std::iota(mesh.indices.begin(), mesh.indices.end(), 0u);
+	}
+	else
+	{
+		mesh.indices = source.indices;
+	}
+	for (uint32_t& index : mesh.indices)
+		index = weldRemap[index];
+
+	// strips and loops are drawn in the order they were authored
+	bool triangleList = mesh.drawMode == GL_TRIANGLES;
+	if (triangleList)
+		mesh.acmrBefore = mesh.acmrAfter = GetACMR(mesh.indices, mesh.vertexCount, options.cacheSize);
+
+	if (triangleList && options.optimiseVertexCache)
+	{
+		mesh.indices = OptimiseVertexCache(mesh.indices, mesh.vertexCount, options.cacheSize);
+		mesh.acmrAfter = GetACMR(mesh.indices, mesh.vertexCount, options.cacheSize);
+	}
+
+	if (options.optimiseVertexFetch)
+	{
+		std::vector<uint32_t> remap = OptimiseVertexFetch(mesh.indices, mesh.vertexCount);
+		std::vector<uint8_t> reordered(mesh.vertices.size());
+		unsigned used = 0;
+		for (unsigned v = 0; v < mesh.vertexCount; ++v)
+		{
+			if (remap[v] == UnusedVertex)
+				continue;
+			std::memcpy(reordered.data() + remap[v] * stride, mesh.vertices.data() + v * stride, stride);
+			++used;
+		}
+		// unreferenced vertices fall off the end
+		reordered.resize(used * stride);
+		mesh.vertices = std::move(reordered);
+		mesh.vertexCount = used;
+	}
+	return mesh;
+}
+
+bool Engine::Rendering::WriteMeshFile(const std::string& path, const CompiledMesh& mesh)
+{
+	const std::vector<VertexAttribute>& attributes = mesh.layout.GetAttributes();
+	if (attributes.size() > MeshFileMaxAttributes)
+		return false;
+
+	bool shortIndices = mesh.vertexCount <= 0x10000;
+	size_t indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	MeshFileHeader header{};
+	header.magic = MeshFileMagic;
+	header.version = MeshFileVersion;
+	header.drawMode = mesh.drawMode;
+	header.indexType = shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	header.vertexCount = mesh.vertexCount;
+	header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	header.stride = mesh.layout.GetStride();
+	header.attributeCount = static_cast<uint32_t>(attributes.size());
+	for (size_t i = 0; i < attributes.size(); ++i)
+	{
+		header.attributes[i] = MeshFileAttribute{ static_cast<uint8_t>(attributes[i].semantic),
+			static_cast<uint8_t>(attributes[i].format), attributes[i].offset, attributes[i].location };
+	}
+	header.vertexOffset = Align(sizeof(MeshFileHeader));
+	header.vertexSize = mesh.vertices.size();
+	header.indexOffset = Align(header.vertexOffset + header.vertexSize);
+	header.indexSize = mesh.indices.size() * indexSize;
+	for (int i = 0; i < 3; ++i)
+	{
+		header.boundsMin[i] = mesh.boundsMin[i];
+		header.boundsMax[i] = mesh.boundsMax[i];
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	const char padding[MeshFileAlignment] = {};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(padding, header.vertexOffset - sizeof(header));
+	file.write(reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size());
+	file.write(padding, header.indexOffset - header.vertexOffset - header.vertexSize);
+	if (shortIndices)
+	{
+		std::vector<uint16_t> indices(mesh.indices.begin(), mesh.indices.end());
+		file.write(reinterpret_cast<const char*>(indices.data()), header.indexSize);
+	}
+	else
+	{
+		file.write(reinterpret_cast<const char*>(mesh.indices.data()), header.indexSize);
+	}
+	return file.good();
+}
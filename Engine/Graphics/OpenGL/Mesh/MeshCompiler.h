@@ -0,0 +1,72 @@
+#pragma once
+#define GLEW_STATIC
+#include "glew/glew.h"
+#include "glm/glm/glm.hpp"
+#include "../GraphicsCore/VertexLayout.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		// a mesh as it comes out of a modelling tool, only positions are required
+		struct MeshSource
+		{
+			std::vector<glm::vec3> positions;
+			std::vector<glm::vec4> colors;
+			std::vector<glm::vec2> texCoords;
+			std::vector<glm::vec3> normals;
+			// empty draws the vertices in order
+			std::vector<uint32_t> indices;
+			GLenum drawMode = GL_TRIANGLES;
+		};
+
+		struct MeshCompileOptions
+		{
+			// entries of the post transform cache the triangle order is tuned for
+			unsigned cacheSize = 32;
+			// largest error allowed when positions are stored as halves, full floats are used past it
+			float positionTolerance = 1.f / 256.f;
+			bool optimiseVertexCache = true;
+			bool optimiseVertexFetch = true;
+		};
+
+		struct CompiledMesh
+		{
+			VertexLayout layout;
+			std::vector<uint8_t> vertices;
+			std::vector<uint32_t> indices;
+			unsigned vertexCount = 0;
+			GLenum drawMode = GL_TRIANGLES;
+			glm::vec3 boundsMin{ 0.f };
+			glm::vec3 boundsMax{ 0.f };
+			// average transformed vertices per triangle, before and after the cache optimisation
+			float acmrBefore = 0.f;
+			float acmrAfter = 0.f;
+		};
+
+		/*
+		everything the runtime should not have to do when loading a mesh
+		picks the smallest layout that keeps the mesh within tolerance, packs the vertices,
+		welds the ones that end up identical, reorders triangles for the post transform cache
+		and then vertices by first use so the fetches walk the vertex buffer forwards
+		*/
+		CompiledMesh CompileMesh(const MeshSource& source, const MeshCompileOptions& options = {});
+
+		// writes the .emesh file LoadMeshFile maps, false if it could not be written
+		bool WriteMeshFile(const std::string& path, const CompiledMesh& mesh);
+
+		// cache misses per triangle with a FIFO cache of cacheSize entries, 0.5 is the best a grid can do and 3 the worst
+		float GetACMR(const std::vector<uint32_t>& indices, unsigned vertexCount, unsigned cacheSize);
+
+		// Forsyth's linear speed ordering, triangle lists only
+		std::vector<uint32_t> OptimiseVertexCache(const std::vector<uint32_t>& indices, unsigned vertexCount, unsigned cacheSize);
+
+		// renumbers vertices in the order indices first use them and rewrites indices to match,
+		// returns the new index of every old vertex or UnusedVertex for the ones nothing referenced
+		constexpr uint32_t UnusedVertex = ~0u;
+		std::vector<uint32_t> OptimiseVertexFetch(std::vector<uint32_t>& indices, unsigned vertexCount);
+	}
+}
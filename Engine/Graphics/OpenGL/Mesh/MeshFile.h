@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		// "EMSH"
+		constexpr uint32_t MeshFileMagic = 0x48534D45;
+		// bump whenever MeshFileHeader or the data after it changes
+		constexpr uint32_t MeshFileVersion = 1;
+		constexpr uint32_t MeshFileMaxAttributes = 8;
+		// vertex and index data start on this so they can go to GL straight out of the mapped file
+		constexpr uint32_t MeshFileAlignment = 16;
+
+		// a VertexAttribute with fixed size fields
+		struct MeshFileAttribute
+		{
+			uint8_t semantic;
+			uint8_t format;
+			uint16_t offset;
+			uint32_t location;
+		};
+
+		/*
+		start of a .emesh file written by WriteMeshFile, everything is little endian
+		the vertices are packed exactly as attributes describes and the indices are
+		already in indexType, so loading is a check of the header and two uploads
+		*/
+		struct MeshFileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t drawMode;
+			uint32_t indexType;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t stride;
+			uint32_t attributeCount;
+			MeshFileAttribute attributes[MeshFileMaxAttributes];
+			// from the start of the file
+			uint64_t vertexOffset;
+			uint64_t vertexSize;
+			uint64_t indexOffset;
+			uint64_t indexSize;
+			// of the positions before they were quantized
+			float boundsMin[3];
+			float boundsMax[3];
+		};
+
+		static_assert(std::is_trivially_copyable_v<MeshFileHeader>, "the header is read straight out of the file");
+	}
+}
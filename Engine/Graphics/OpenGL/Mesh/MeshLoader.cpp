@@ -0,0 +1,78 @@
+#include "MeshLoader.h"
+#include "MeshFile.h"
+#include "Snapshot.h"
+#include "Logger.h"
+
+using namespace Engine::Rendering;
+
+namespace
+{
+	bool Fail(const std::string& path, const char* reason)
+	{
+		Logger::GetInstance()->Log("Failed to load mesh " + path + ": " + reason);
+		return false;
+	}
+
+	bool InFile(uint64_t offset, uint64_t size, size_t fileSize)
+	{
+		return offset % MeshFileAlignment == 0 && offset <= fileSize && size <= fileSize - offset;
+	}
+}
+
+bool Engine::Rendering::LoadMeshFile(const std::string& path, Mesh& mesh)
+{
+	Snapshot::MappedFile file{ path };
+	if (!file.IsOpen())
+		return Fail(path, "could not be mapped");
+	if (file.GetSize() < sizeof(MeshFileHeader))
+		return Fail(path, "too small");
+
+	// the view is page aligned, so the header is too
+	const MeshFileHeader& header = *reinterpret_cast<const MeshFileHeader*>(file.GetData());
+	if (header.magic != MeshFileMagic)
+		return Fail(path, "not a mesh file");
+	if (header.version != MeshFileVersion)
+		return Fail(path, "written by a different version of the mesh compiler");
+	if (header.attributeCount > MeshFileMaxAttributes)
+		return Fail(path, "too many attributes");
+
+	VertexLayout layout;
+	for (uint32_t i = 0; i < header.attributeCount; ++i)
+	{
+		const MeshFileAttribute& attribute = header.attributes[i];
+		if (attribute.semantic > uint8_t(VertexSemantic::Normal) || attribute.format > uint8_t(VertexFormat::SNorm10x3_2))
+			return Fail(path, "unknown attribute");
+		layout.Add(static_cast<VertexSemantic>(attribute.semantic), static_cast<VertexFormat>(attribute.format), attribute.location);
+		if (layout.GetAttributes().back().offset != attribute.offset)
+			return Fail(path, "attributes are not packed the way the layout would pack them");
+	}
+
+	size_t indexSize = header.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	if (header.indexType != GL_UNSIGNED_SHORT && header.indexType != GL_UNSIGNED_INT)
+		return Fail(path, "unknown index type");
+	if (layout.GetStride() != header.stride || uint64_t(header.vertexCount) * header.stride != header.vertexSize ||
+		uint64_t(header.indexCount) * indexSize != header.indexSize)
+		return Fail(path, "sizes do not add up");
+	if (!InFile(header.vertexOffset, header.vertexSize, file.GetSize()) || !InFile(header.indexOffset, header.indexSize, file.GetSize()))
+		return Fail(path, "truncated");
+
+	glGenVertexArrays(1, &mesh.VAOref);
+	glGenBuffers(1, &mesh.VBOref);
+	glGenBuffers(1, &mesh.EBOref);
+	glBindVertexArray(mesh.VAOref);
+
+	// GL copies out of the mapped pages, the OS reads them in as it goes
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBOref);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(header.vertexSize), file.GetData() + header.vertexOffset, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBOref);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(header.indexSize), file.GetData() + header.indexOffset, GL_STATIC_DRAW);
+	layout.Apply();
+	glBindVertexArray(0);
+
+	mesh.Clear();
+	mesh.VAO.SetLayout(std::move(layout));
+	mesh.drawMode = header.drawMode;
+	mesh.indexType = header.indexType;
+	mesh.indexCount = static_cast<GLsizei>(header.indexCount);
+	return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "Mesh.h"
+#include <string>
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		/*
+		maps a .emesh file written by WriteMeshFile and uploads it straight from the mapped pages,
+		the header is checked but nothing is parsed or converted, the file is unmapped once GL has the data
+		mesh gets new buffers and its layout, IA and the vertex array object's data stay empty
+		needs the context, so call it from the render thread while it is running
+		*/
+		bool LoadMeshFile(const std::string& path, Mesh& mesh);
+	}
+}
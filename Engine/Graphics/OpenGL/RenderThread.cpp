@@ -0,0 +1,194 @@
+#include "RenderThread.h"
+#include "GraphicSystem.h"
+#include "Logger.h"
+
+using namespace Engine::Rendering;
+
+RenderThread* RenderThread::instance = nullptr;
+
+namespace
+{
+	std::mutex s_instanceLock;
+}
+
+void FramePacket::Clear()
+{
+	batches.clear();
+	instances.clear();
+}
+
+void FramePacket::BeginBatch(const Sprite& sprite, uint8_t layer, uint16_t depth)
+{
+	batches.push_back(SpriteBatch{ sprite, instances.size(), 0, layer, depth });
+}
+
+void FramePacket::Add(const glm::mat4& transform, const glm::vec4& color)
+{
+	instances.push_back(SpriteInstance{ transform, color });
+	++batches.back().count;
+}
+
+RenderThread::~RenderThread()
+{
+	Stop();
+	m_stream.Release();
+}
+
+RenderThread* RenderThread::GetInstance()
+{
+	std::lock_guard lock{ s_instanceLock };
+	if (!instance)
+		instance = new RenderThread{};
+	return instance;
+}
+
+void RenderThread::Exit()
+{
+	std::lock_guard lock{ s_instanceLock };
+	delete instance;
+	instance = nullptr;
+}
+
+void RenderThread::Start(GraphicsSystem_OpenGL* gs)
+{
+	if (m_running)
+		return;
+
+	m_gs = gs;
+	m_quit = false;
+	m_submitted = false;
+	// a context can only be current on one thread
+	m_gs->ReleaseContext();
+	m_running = true;
+	m_thread = std::thread{ &RenderThread::ThreadMain, this };
+	Logger::GetInstance()->Log("Render thread started");
+}
+
+void RenderThread::Stop()
+{
+	if (!m_running)
+		return;
+
+	{
+		std::lock_guard lock{ m_lock };
+		m_quit = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+	m_running = false;
+
+	m_gs->MakeContextCurrent();
+	Logger::GetInstance()->Log("Render thread stopped");
+}
+
+bool RenderThread::IsRunning() const
+{
+	return m_running;
+}
+
+FramePacket& RenderThread::GetPacket()
+{
+	return m_packets[m_write];
+}
+
+void RenderThread::Submit()
+{
+	if (!m_running)
+	{
+		if (!m_gs)
+			m_gs = GraphicsSystem_OpenGL::GetInstance();
+		Draw(m_packets[m_write]);
+		m_packets[m_write].Clear();
+		return;
+	}
+
+	{
+		std::unique_lock lock{ m_lock };
+		// the packet about to be filled is the one the render thread may still be drawing
+		m_done.wait(lock, [&]() { return !m_submitted; });
+		m_write ^= 1;
+		m_submitted = true;
+	}
+	m_wake.notify_one();
+	m_packets[m_write].Clear();
+}
+
+void RenderThread::Enqueue(std::function<void()> command)
+{
+	if (!m_running)
+	{
+		command();
+		return;
+	}
+
+	{
+		std::lock_guard lock{ m_lock };
+		m_commands.push_back(std::move(command));
+		++m_commandsQueued;
+	}
+	m_wake.notify_one();
+}
+
+void RenderThread::Flush()
+{
+	if (!m_running)
+		return;
+
+	std::unique_lock lock{ m_lock };
+	uint64_t target = m_commandsQueued;
+	m_done.wait(lock, [&]() { return m_commandsRun >= target; });
+}
+
+void RenderThread::ThreadMain()
+{
+	if (!m_gs->MakeContextCurrent())
+		Logger::GetInstance()->Log("Render thread could not take over the GL context");
+
+	std::unique_lock lock{ m_lock };
+	while (true)
+	{
+		m_wake.wait(lock, [&]() { return m_quit || m_submitted || !m_commands.empty(); });
+
+		std::vector<std::function<void()>> commands;
+		commands.swap(m_commands);
+		bool draw = m_submitted;
+		// the main thread moved on to the other packet when it submitted this one
+		FramePacket& packet = m_packets[m_write ^ 1];
+		lock.unlock();
+
+		for (auto& command : commands)
+			command();
+		if (draw)
+			Draw(packet);
+
+		lock.lock();
+		m_commandsRun += commands.size();
+		if (draw)
+			m_submitted = false;
+		m_done.notify_all();
+
+		if (m_quit && !m_submitted && m_commands.empty())
+			break;
+	}
+	lock.unlock();
+
+	m_gs->ReleaseContext();
+}
+
+void RenderThread::Draw(FramePacket& packet)
+{
+	// everything the frame writes goes into the stream before anything is drawn
+	m_stream.BeginFrame(m_uniforms.GetFootprint(sizeof(FrameData)) + SpriteRenderer::GetUploadSize(packet.instances));
+	m_uniforms.Begin(m_stream);
+	UniformArena::Block frameData = m_uniforms.Push(FrameData{ packet.worldTrans });
+	m_sprites.Upload(m_stream, packet.instances);
+	m_stream.Commit();
+
+	m_gs->UpdateBegin();
+	// shared by every draw, uploaded and bound once
+	if (!UniformArena::Bind(FrameDataBinding, frameData))
+		Logger::GetInstance()->Log("FrameData could not be placed in the stream buffer, the frame uses the last one bound");
+	m_sprites.Draw(packet.batches);
+	m_stream.EndFrame();
+	m_gs->UpdateEnd();
+}
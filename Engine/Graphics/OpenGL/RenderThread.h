@@ -0,0 +1,98 @@
+#pragma once
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Sprite/SpriteRenderer.h"
+#include "glm/glm/glm.hpp"
+
+class GraphicsSystem_OpenGL;
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		/*
+		everything the render thread needs to draw one frame, copied out of the world
+		so the simulation can carry on with the next frame while this one is drawn
+		*/
+		struct FramePacket
+		{
+			glm::mat4 worldTrans{ 1.f };
+			std::vector<SpriteBatch> batches;
+			std::vector<SpriteInstance> instances;
+
+			// keeps the capacity so a steady scene stops allocating
+			void Clear();
+			// the instances added after this are drawn with sprite
+			void BeginBatch(const Sprite& sprite, uint8_t layer = 0, uint16_t depth = 0);
+			void Add(const glm::mat4& transform, const glm::vec4& color);
+		};
+
+		/*
+		draws frame packets on its own thread, which owns the GL context while it runs
+		there are two packets, the main thread fills one while the render thread draws the other,
+		Submit only waits if the previous frame has not been drawn yet,
+		so at most one frame is ever in flight
+		anything else that has to touch GL while the thread runs goes through Enqueue
+		when the thread is not running everything happens on the calling thread instead
+		*/
+		class RenderThread
+		{
+			static RenderThread* instance;
+
+			GraphicsSystem_OpenGL* m_gs = nullptr;
+			std::thread m_thread;
+			// only used by whichever thread owns the context
+			StreamBuffer m_stream;
+			UniformArena m_uniforms;
+			SpriteRenderer m_sprites;
+
+			std::array<FramePacket, 2> m_packets;
+			// main thread fills m_packets[m_write], the render thread draws the other one
+			unsigned m_write = 0;
+
+			std::mutex m_lock;
+			std::condition_variable m_wake;
+			std::condition_variable m_done;
+			// a packet is waiting for or being drawn
+			bool m_submitted = false;
+			bool m_quit = false;
+			bool m_running = false;
+
+			std::vector<std::function<void()>> m_commands;
+			uint64_t m_commandsQueued = 0;
+			uint64_t m_commandsRun = 0;
+
+			void ThreadMain();
+			void Draw(FramePacket& packet);
+
+			RenderThread() = default;
+			~RenderThread();
+
+		public:
+			static RenderThread* GetInstance();
+			static void Exit();
+
+			// takes the GL context off the calling thread and hands it to the render thread
+			void Start(GraphicsSystem_OpenGL* gs);
+			// draws whatever is outstanding and gives the context back to the calling thread
+			void Stop();
+			bool IsRunning() const;
+
+			// the packet to fill for the next frame, cleared by Submit once it has been handed over
+			FramePacket& GetPacket();
+			// hands the filled packet over to be drawn and presented
+			void Submit();
+
+			// runs command on the thread that owns the context, before the next frame is drawn
+			void Enqueue(std::function<void()> command);
+			// waits for everything enqueued so far to have run
+			void Flush();
+		};
+	}
+}
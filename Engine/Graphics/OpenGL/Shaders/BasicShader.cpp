@@ -14,11 +14,21 @@ Which is used to wrap shader code
 */
 /******************************************************************************/
 #include "BasicShader.h"
+#include "Logger.h"
 
 #include <stdio.h>
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+namespace
+{
+  // 0 is left for programs that never linked
+  std::atomic<uint32_t> s_nextLinkID = 1;
+}
 
 ShaderProgram::ShaderProgram():
   m_vertexSource{
@@ -114,80 +124,187 @@ bool ShaderProgram::LoadShader()
 
   const char* fs_src = m_fragmentSource.c_str();
 
-
-  GLint compiled = 0;
-  // Create and compile vertex shader
+  // compile status is left for FinishSetup, asking for it here would wait on the compiler
   if(m_vertexShaderId)
     glDeleteShader(m_vertexShaderId);
   m_vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
   glShaderSource(m_vertexShaderId, 1, &vs_src, NULL);
   glCompileShader(m_vertexShaderId);
-  glGetShaderiv(m_vertexShaderId, GL_COMPILE_STATUS, &compiled);
-
-  if (!compiled)
-  {
-    GLchar infoLog[512];
-    glGetShaderInfoLog(m_vertexShaderId, 512, NULL, infoLog);
-    std::string log("Vertex Shader Compile Error:\n");
-    log += infoLog;
-
-    //LOG it
-    //INF_CORE_ERROR(log);
-		assert(false);
-    return false;
-  }
-
-  compiled = 0;
 
-  // Create and compile fragment shader
   if(m_fragmentShaderId)
     glDeleteShader(m_fragmentShaderId);
 
   m_fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
   glShaderSource(m_fragmentShaderId, 1, &fs_src, NULL);
   glCompileShader(m_fragmentShaderId);
-  glGetShaderiv(m_fragmentShaderId, GL_COMPILE_STATUS, &compiled);
 
-  if (!compiled)
+  glAttachShader(m_pendingProgramId, m_vertexShaderId);
+  glAttachShader(m_pendingProgramId, m_fragmentShaderId);
+
+  for (auto& attachment : m_attachmentList)
   {
-    GLchar infoLog[512];
-    glGetShaderInfoLog(m_fragmentShaderId, 512, NULL, infoLog);
-    std::string log("Fragment Shader Compile Error:\n");
-    log += infoLog;
-    //LOG it
-    //INF_CORE_ERROR(log);
-		assert(false);
-    return false;
+    // BeginSetup read the source already
+    attachment.Compile();
+    glAttachShader(m_pendingProgramId, attachment.GetShaderID());
   }
 
-  glAttachShader(m_shaderProgramId, m_vertexShaderId);
-  glAttachShader(m_shaderProgramId, m_fragmentShaderId);
+  if (m_cache && m_cache->IsSupported())
+    glProgramParameteri(m_pendingProgramId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glLinkProgram(m_pendingProgramId);
+  return true;
+}
 
-  for (auto& attachment : m_attachmentList)
+void ShaderProgram::LogBuildErrors(GLuint program) const
+{
+  std::string log = "Shader " + m_shaderName + " failed to build";
+
+  auto appendLog = [&log](const char* stage, GLuint shader)
   {
-    attachment.Setup();
-    glAttachShader(m_shaderProgramId, attachment.GetShaderID());
+    GLint compiled = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled)
+      return;
+    GLint length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> infoLog(std::max(length, 1));
+    glGetShaderInfoLog(shader, static_cast<GLsizei>(infoLog.size()), NULL, infoLog.data());
+    log += "\n";
+    log += stage;
+    log += " Shader Compile Error:\n";
+    log += infoLog.data();
+  };
+  if (m_vertexShaderId)
+    appendLog("Vertex", m_vertexShaderId);
+  if (m_fragmentShaderId)
+    appendLog("Fragment", m_fragmentShaderId);
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+  std::vector<GLchar> infoLog(std::max(length, 1));
+  glGetProgramInfoLog(program, static_cast<GLsizei>(infoLog.size()), NULL, infoLog.data());
+  log += "\nShader Link Error:\n";
+  log += infoLog.data();
+
+  Logger::GetInstance()->Log(log);
+}
+
+void ShaderProgram::Reflect()
+{
+  m_uniforms.clear();
+  m_uniformBlocks.clear();
+
+  GLint count = 0;
+  GLint maxLength = 0;
+  glGetProgramiv(m_shaderProgramId, GL_ACTIVE_UNIFORMS, &count);
+  glGetProgramiv(m_shaderProgramId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+  std::vector<GLchar> buffer(std::max(maxLength, 1));
+  for (GLint i = 0; i < count; ++i)
+  {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(m_shaderProgramId, i, maxLength, &length, &size, &type, buffer.data());
+    std::string name(buffer.data(), length);
+
+    // members of uniform blocks have no location of their own
+    GLint location = glGetUniformLocation(m_shaderProgramId, name.c_str());
+    if (location == -1)
+      continue;
+
+    if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+      name.resize(name.size() - 3);
+    m_uniforms.push_back(UniformInfo{ HashUniformName(name), location, type, size, std::move(name) });
   }
 
-  GLint linked = 0;
-  glLinkProgram(m_shaderProgramId);
-  glGetProgramiv(m_shaderProgramId, GL_LINK_STATUS, &linked);
+  glGetProgramiv(m_shaderProgramId, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+  glGetProgramiv(m_shaderProgramId, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+  buffer.resize(std::max(maxLength, 1));
+  for (GLint i = 0; i < count; ++i)
+  {
+    GLsizei length = 0;
+    glGetActiveUniformBlockName(m_shaderProgramId, i, maxLength, &length, buffer.data());
+    std::string name(buffer.data(), length);
+
+    GLint dataSize = 0;
+    GLint binding = 0;
+    glGetActiveUniformBlockiv(m_shaderProgramId, i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    glGetActiveUniformBlockiv(m_shaderProgramId, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+    m_uniformBlocks.push_back(UniformBlockInfo{ HashUniformName(name), static_cast<GLuint>(i), dataSize, binding, std::move(name) });
+  }
 
-  if (!linked)
+  auto byHash = [](const auto& lhs, const auto& rhs) { return lhs.hash < rhs.hash; };
+  std::sort(m_uniforms.begin(), m_uniforms.end(), byHash);
+  std::sort(m_uniformBlocks.begin(), m_uniformBlocks.end(), byHash);
+
+  // lookups compare names so both still work, but it is worth knowing about
+  auto logCollisions = [this](const auto& list, const char* kind)
   {
-    GLint  length;
-    glGetProgramiv(m_shaderProgramId, GL_INFO_LOG_LENGTH, &length);
-    std::vector<GLchar> infoLog(length);
-    glGetProgramInfoLog(m_shaderProgramId, length, &length, &infoLog[0]);
-    std::string log("Shader Link Error:\n");
-    log += &infoLog[0];
-    //LOG it
-		//std::cout << (log) << std::endl;
-		assert(false);
+    for (size_t i = 1; i < list.size(); ++i)
+    {
+      if (list[i - 1].hash == list[i].hash)
+        Logger::GetInstance()->Log("Shader " + m_shaderName + ": " + kind + " " + list[i - 1].name +
+          " and " + list[i].name + " have the same hash");
+    }
+  };
+  logCollisions(m_uniforms, "uniforms");
+  logCollisions(m_uniformBlocks, "uniform blocks");
+
+  m_linkID = s_nextLinkID++;
+}
+
+namespace
+{
+  // the entries with hash, sorted by hash, with the right name
+  template<typename Info>
+  const Info* FindByName(const std::vector<Info>& list, uint32_t hash, std::string_view name)
+  {
+    auto itr = std::lower_bound(list.begin(), list.end(), hash,
+      [](const Info& info, uint32_t value) { return info.hash < value; });
+    for (; itr != list.end() && itr->hash == hash; ++itr)
+    {
+      if (itr->name == name)
+        return &*itr;
+    }
+    return nullptr;
+  }
+}
+
+const UniformInfo* ShaderProgram::FindUniform(uint32_t hash, std::string_view name) const
+{
+  return FindByName(m_uniforms, hash, name);
+}
+
+const UniformBlockInfo* ShaderProgram::FindUniformBlock(uint32_t hash, std::string_view name) const
+{
+  return FindByName(m_uniformBlocks, hash, name);
+}
+
+bool ShaderProgram::SetUniformBlockBinding(uint32_t hash, std::string_view name, GLuint binding)
+{
+  UniformBlockInfo* block = const_cast<UniformBlockInfo*>(FindUniformBlock(hash, name));
+  if (!block)
     return false;
+  if (block->binding != static_cast<GLint>(binding))
+  {
+    glUniformBlockBinding(m_shaderProgramId, block->index, binding);
+    block->binding = static_cast<GLint>(binding);
   }
+  return true;
+}
 
-  return compiled;
+const std::vector<UniformInfo>& ShaderProgram::GetUniforms() const
+{
+  return m_uniforms;
+}
+
+const std::vector<UniformBlockInfo>& ShaderProgram::GetUniformBlocks() const
+{
+  return m_uniformBlocks;
+}
+
+uint32_t ShaderProgram::GetLinkID() const
+{
+  return m_linkID;
 }
 
 
@@ -197,17 +314,27 @@ std::string BasicShader::GetShaderName() const
   return shaderProg->GetShaderName();
 }
 
-bool ShaderProgram::Setup()
+bool ShaderProgram::Setup(Engine::Rendering::ProgramCache* cache)
+{
+  return BeginSetup(cache) && FinishSetup();
+}
+
+bool ShaderProgram::BeginSetup(Engine::Rendering::ProgramCache* cache)
 {
+  // a build that was never finished is thrown away
+  if (m_pendingProgramId)
+    glDeleteProgram(m_pendingProgramId);
+  m_cache = cache;
+  m_pendingFromCache = false;
+
   GLenum glErr;
   glErr = glGetError(); // clear error cache
-  GLuint oldProg = m_shaderProgramId;
   // Create prog, attach shaders, and link it
-  m_shaderProgramId = glCreateProgram();
+  m_pendingProgramId = glCreateProgram();
 
   std::string source;
   std::stringstream ss;
-  if (m_vertexFile != "")
+  if (m_vertexFile != "" && !m_vertexSourceSet)
   {
 		std::ifstream fs(m_vertexFile);
 
@@ -226,7 +353,7 @@ bool ShaderProgram::Setup()
 			assert(false);
   }
 
-  if (m_fragmentFile != "")
+  if (m_fragmentFile != "" && !m_fragmentSourceSet)
   {
 		std::ifstream fs(m_fragmentFile);
     
@@ -253,19 +380,111 @@ bool ShaderProgram::Setup()
     error.append(std::to_string(glErr));
     INF_CORE_ERROR(error);
     */
-    m_shaderProgramId = oldProg;
+    glDeleteProgram(m_pendingProgramId);
+    m_pendingProgramId = 0;
 		assert(false);
     return false;
   }
-  if (glIsProgram(oldProg))
+  m_vertexSourceSet = false;
+  m_fragmentSourceSet = false;
+
+  for (auto& attachment : m_attachmentList)
+    attachment.ReadSource();
+
+  if (m_cache)
   {
-    glDeleteProgram(oldProg);
+    std::vector<std::string_view> sources{ m_vertexSource, m_fragmentSource };
+    for (auto& attachment : m_attachmentList)
+      sources.push_back(attachment.GetSource());
+    m_cacheKey = m_cache->GetKey(sources);
+    m_pendingFromCache = m_cache->Load(m_cacheKey, m_pendingProgramId);
+    if (m_pendingFromCache)
+      return true;
   }
   return LoadShader();
 }
 
+bool ShaderProgram::FinishSetup()
+{
+  if (!m_pendingProgramId)
+    return m_shaderProgramId != 0;
+
+  GLuint program = m_pendingProgramId;
+  m_pendingProgramId = 0;
+
+  // blocks until the driver is done with it
+  GLint linked = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (!linked)
+  {
+    LogBuildErrors(program);
+    glDeleteProgram(program);
+    return false;
+  }
+
+  if (glIsProgram(m_shaderProgramId))
+    glDeleteProgram(m_shaderProgramId);
+  m_shaderProgramId = program;
+
+  if (m_cache && !m_pendingFromCache)
+    m_cache->Store(m_cacheKey, program);
+
+  // the linked program keeps its code, the shader objects are only needed to build it
+  if (m_vertexShaderId)
+  {
+    if (!m_pendingFromCache)
+      glDetachShader(program, m_vertexShaderId);
+    glDeleteShader(m_vertexShaderId);
+    m_vertexShaderId = 0;
+  }
+  if (m_fragmentShaderId)
+  {
+    if (!m_pendingFromCache)
+      glDetachShader(program, m_fragmentShaderId);
+    glDeleteShader(m_fragmentShaderId);
+    m_fragmentShaderId = 0;
+  }
+
+  Reflect();
+  return true;
+}
+
+bool ShaderProgram::IsSetupPending() const
+{
+  return m_pendingProgramId != 0;
+}
+
+bool ShaderProgram::IsSetupComplete() const
+{
+  if (!m_pendingProgramId || m_pendingFromCache)
+    return true;
+  if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile)
+    return true;
+  GLint complete = 0;
+  glGetProgramiv(m_pendingProgramId, GL_COMPLETION_STATUS_KHR, &complete);
+  return complete != 0;
+}
+
+void ShaderProgram::SetVertexSource(std::string source)
+{
+  m_vertexSource = std::move(source);
+  m_vertexSourceSet = true;
+}
+
+void ShaderProgram::SetFragmentSource(std::string source)
+{
+  m_fragmentSource = std::move(source);
+  m_fragmentSourceSet = true;
+}
+
 void ShaderProgram::Clean()
 {
+  if (m_pendingProgramId)
+  {
+    glDeleteProgram(m_pendingProgramId);
+    m_pendingProgramId = 0;
+  }
+
   if (m_shaderProgramId)
   {
     if (m_vertexShaderId)
@@ -281,7 +500,7 @@ void ShaderProgram::Clean()
       glDeleteShader(m_fragmentShaderId);
     }
 
-    glDeleteShader(m_shaderProgramId);
+    glDeleteProgram(m_shaderProgramId);
   }
 }
 
@@ -309,62 +528,81 @@ void ShaderProgram::PushUniformBuffer(std::shared_ptr<UniformBuffer> buffer)
   m_UniformBufferStore.push_back(buffer);
 }
 
-void BasicShader::SetFloat(std::string name, float f) const
+namespace
 {
-  glUniform1f(glGetUniformLocation(shaderProg->GetProgramID(), name.c_str()), f);
+  // -1 unless the program has a uniform with exactly this name and a type T can be set on
+  template<typename T>
+  GLint FindLocation(const ShaderProgram& program, std::string_view name)
+  {
+    const UniformInfo* info = program.FindUniform(HashUniformName(name), name);
+    return info && UniformDetails::MatchesType<T>(info->type) ? info->location : -1;
+  }
 }
 
-void BasicShader::SetVector2(std::string name, glm::vec2 vec) const
+void BasicShader::SetFloat(std::string_view name, float f) const
 {
-  glUniform2f(glGetUniformLocation(shaderProg->GetProgramID(), name.c_str()), vec[0], vec[1]);
+  GLint loc = FindLocation<float>(*shaderProg, name);
+  if (loc != -1)
+    glProgramUniform1f(shaderProg->GetProgramID(), loc, f);
 }
 
-void BasicShader::SetVector3(std::string name, glm::vec3 vec) const
+void BasicShader::SetVector2(std::string_view name, glm::vec2 vec) const
 {
-  glUniform3f(glGetUniformLocation(shaderProg->GetProgramID(), name.c_str()), vec[0], vec[1], vec[2]);
+  GLint loc = FindLocation<glm::vec2>(*shaderProg, name);
+  if (loc != -1)
+    glProgramUniform2f(shaderProg->GetProgramID(), loc, vec[0], vec[1]);
 }
 
-void BasicShader::SetVector4(std::string name, glm::vec4 vec) const
+void BasicShader::SetVector3(std::string_view name, glm::vec3 vec) const
 {
-  glUniform4f(glGetUniformLocation(shaderProg->GetProgramID(), name.c_str()), vec[0], vec[1], vec[2], vec[3]);
+  GLint loc = FindLocation<glm::vec3>(*shaderProg, name);
+  if (loc != -1)
+    glProgramUniform3f(shaderProg->GetProgramID(), loc, vec[0], vec[1], vec[2]);
 }
 
-void BasicShader::SetInt(std::string name, int i) const
+void BasicShader::SetVector4(std::string_view name, glm::vec4 vec) const
 {
-  glUniform1i(glGetUniformLocation(shaderProg->GetProgramID(), name.c_str()), i);
+  GLint loc = FindLocation<glm::vec4>(*shaderProg, name);
+  if (loc != -1)
+    glProgramUniform4f(shaderProg->GetProgramID(), loc, vec[0], vec[1], vec[2], vec[3]);
 }
 
-void BasicShader::SetMat(std::string name, glm::mat3 mat) const
+void BasicShader::SetInt(std::string_view name, int i) const
 {
-  if (!shaderProg->GetProgramID())
-    return;
-  GLint loc = glGetUniformLocation(shaderProg->GetProgramID(), name.c_str());
+  GLint loc = FindLocation<int>(*shaderProg, name);
+  if (loc != -1)
+    glProgramUniform1i(shaderProg->GetProgramID(), loc, i);
+}
+
+void BasicShader::SetMat(std::string_view name, const glm::mat3& mat) const
+{
+  GLint loc = FindLocation<glm::mat3>(*shaderProg, name);
   if (loc == -1)
     return;
 
   glProgramUniformMatrix3fv(shaderProg->GetProgramID(), loc, 1, GL_FALSE, &mat[0][0]);
 }
 
-void BasicShader::SetMat(std::string name, glm::mat4 mat) const
+void BasicShader::SetMat(std::string_view name, const glm::mat4& mat) const
 {
-  if (!shaderProg->GetProgramID())
-    return;
-  GLint loc = glGetUniformLocation(shaderProg->GetProgramID(), name.c_str());
+  GLint loc = FindLocation<glm::mat4>(*shaderProg, name);
   if (loc == -1)
     return;
   glProgramUniformMatrix4fv(shaderProg->GetProgramID(), loc, 1, GL_FALSE, &mat[0][0]);
 }
 
-void BasicShader::SetFloatArray(std::string name, int arraySize, const float* arr) const
+void BasicShader::SetFloatArray(std::string_view name, int arraySize, const float* arr) const
 {
-  glProgramUniform1fv(shaderProg->GetProgramID(),
-    glGetUniformLocation(shaderProg->GetProgramID(), name.c_str()), arraySize, arr);
+  GLint loc = FindLocation<float>(*shaderProg, name);
+  if (loc != -1)
+    glProgramUniform1fv(shaderProg->GetProgramID(), loc, arraySize, arr);
 }
 
-void BasicShader::SetIntArray(std::string name, int arraySize, const int* arr) const
+void BasicShader::SetIntArray(std::string_view name, int arraySize, const int* arr) const
 {
-  glProgramUniform1iv(shaderProg->GetProgramID(),
-    glGetUniformLocation(shaderProg->GetProgramID(), name.c_str()), arraySize, arr);
+  GLint loc = FindLocation<int>(*shaderProg, name);
+  if (loc != -1)
+    glProgramUniform1iv(shaderProg->GetProgramID(), loc, arraySize, arr);
 }
 
 void BasicShader::Start() const
@@ -24,6 +24,8 @@ Which is used to wrap shader code
 
 #include "ShaderAttachment.h"
 #include "UniformBuffer.h"
+#include "ShaderUniform.h"
+#include "ProgramCache.h"
 #include "glm/glm/glm.hpp"
 
 struct ShaderProgram
@@ -33,12 +35,29 @@ private:
   GLuint m_vertexShaderId = { 0 };  // vertex shader Id
   GLuint m_fragmentShaderId = { 0 };  // fragment shader Id
   GLuint m_shaderProgramId = { 0 };
+  // being built by BeginSetup, replaces m_shaderProgramId once FinishSetup sees it linked
+  GLuint m_pendingProgramId = { 0 };
+  bool m_pendingFromCache = false;
+  Engine::Rendering::ProgramCache* m_cache = nullptr;
+  uint64_t m_cacheKey = 0;
 
   std::string m_vertexSource;
   std::string m_fragmentSource;
   std::string m_geometrySource;
+  // set by SetVertexSource and SetFragmentSource, the next BeginSetup uses them instead of reading the files
+  bool m_vertexSourceSet = false;
+  bool m_fragmentSourceSet = false;
 
   std::string m_shaderName;
+
+  // filled after every successful link, sorted by hash
+  std::vector<UniformInfo> m_uniforms;
+  std::vector<UniformBlockInfo> m_uniformBlocks;
+  // unique for every link of every program, handles re-resolve when it changes
+  uint32_t m_linkID = 0;
+
+  void Reflect();
+  void LogBuildErrors(GLuint program) const;
 public:
   std::vector<std::shared_ptr<UniformBuffer>> m_UniformBufferStore;
 
@@ -50,8 +69,25 @@ public:
 
   ShaderProgram();
 
-  bool Setup();//shaders code inside
-
+  // builds the program and waits for it, BeginSetup followed by FinishSetup
+  bool Setup(Engine::Rendering::ProgramCache* cache = nullptr);
+
+  // reads the sources and loads the program from cache or starts compiling and linking it,
+  // the link status is only read in FinishSetup so the driver can build many programs at once
+  // the current program stays in use until then
+  bool BeginSetup(Engine::Rendering::ProgramCache* cache = nullptr);
+  // waits for the program BeginSetup started and swaps it in if it linked,
+  // keeps the previous program and logs why if it did not
+  bool FinishSetup();
+  bool IsSetupPending() const;
+  // true once FinishSetup would not have to wait, always true when the driver cannot be asked
+  bool IsSetupComplete() const;
+
+  // for callers that already read the files, such as hot reload
+  void SetVertexSource(std::string source);
+  void SetFragmentSource(std::string source);
+
+  // compiles and links the sources into the pending program without waiting on either
   bool LoadShader();
 
   void Clean();
@@ -65,6 +101,18 @@ public:
   void ClearAttachments();
 
   void PushUniformBuffer(std::shared_ptr<UniformBuffer> buffer);
+
+  // null if the linked program has no such active uniform, hash is HashUniformName(name)
+  // and narrows the search, the name is what decides so two names sharing a hash never mix up
+  const UniformInfo* FindUniform(uint32_t hash, std::string_view name) const;
+  const UniformBlockInfo* FindUniformBlock(uint32_t hash, std::string_view name) const;
+  // points the block at a binding point, only calls GL when it is not there already
+  // false if the program has no such block
+  bool SetUniformBlockBinding(uint32_t hash, std::string_view name, GLuint binding);
+
+  const std::vector<UniformInfo>& GetUniforms() const;
+  const std::vector<UniformBlockInfo>& GetUniformBlocks() const;
+  uint32_t GetLinkID() const;
 };
 
 class BasicShader
@@ -95,15 +143,35 @@ public:
   void SetVariables() const;
 
 
-  void SetFloat(std::string name, float f) const;
-  void SetVector2(std::string name, glm::vec2 vec) const;
-  void SetVector3(std::string name, glm::vec3 vec) const;
-  void SetVector4(std::string name, glm::vec4 vec) const;
-  void SetInt(std::string name, int i) const;
-  void SetMat(std::string name, glm::mat3 mat) const;
-  void SetMat(std::string name, glm::mat4 mat) const;
-  void SetFloatArray(std::string name, int arraySize, const float* arr) const;
-  void SetIntArray(std::string name, int arraySize, const int* arr) const;
+  // looked up by name in the reflected table, prefer handles for anything set every draw
+  void SetFloat(std::string_view name, float f) const;
+  void SetVector2(std::string_view name, glm::vec2 vec) const;
+  void SetVector3(std::string_view name, glm::vec3 vec) const;
+  void SetVector4(std::string_view name, glm::vec4 vec) const;
+  void SetInt(std::string_view name, int i) const;
+  void SetMat(std::string_view name, const glm::mat3& mat) const;
+  void SetMat(std::string_view name, const glm::mat4& mat) const;
+  void SetFloatArray(std::string_view name, int arraySize, const float* arr) const;
+  void SetIntArray(std::string_view name, int arraySize, const int* arr) const;
+
+  // finds the handle's location in this shader, -1 if missing or of another type
+  template<typename T>
+  void Resolve(UniformHandle<T>& uniform) const
+  {
+    const UniformInfo* info = shaderProg->FindUniform(uniform.hash, uniform.name);
+    uniform.location = info && UniformDetails::MatchesType<T>(info->type) ? info->location : -1;
+    uniform.linkID = shaderProg->GetLinkID();
+  }
+
+  // no string work and a single GL call once the handle is resolved for this shader
+  template<typename T>
+  void Set(UniformHandle<T>& uniform, const T& value) const
+  {
+    if (uniform.linkID != shaderProg->GetLinkID())
+      Resolve(uniform);
+    if (uniform.location != -1)
+      UniformDetails::Upload(shaderProg->GetProgramID(), uniform.location, value);
+  }
 
   void Start() const;
   void End() const;
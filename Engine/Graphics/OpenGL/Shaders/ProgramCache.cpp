@@ -0,0 +1,149 @@
+#include "ProgramCache.h"
+#include "Logger.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+using namespace Engine::Rendering;
+
+namespace
+{
+  // "EPRG"
+  constexpr uint32_t CacheMagic = 0x47525045;
+  // bump to throw every stored binary away
+  constexpr uint32_t CacheVersion = 1;
+
+  struct CacheHeader
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;
+  };
+
+  constexpr uint64_t FnvOffset = 0xcbf29ce484222325ull;
+  constexpr uint64_t FnvPrime = 0x100000001b3ull;
+
+  uint64_t Hash(uint64_t hash, const void* data, size_t size)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+      hash = (hash ^ bytes[i]) * FnvPrime;
+    return hash;
+  }
+
+  // the length goes in first so "ab" + "c" and "a" + "bc" hash differently
+  uint64_t Hash(uint64_t hash, std::string_view str)
+  {
+    uint64_t size = str.size();
+    hash = Hash(hash, &size, sizeof(size));
+    return Hash(hash, str.data(), str.size());
+  }
+
+  std::string GetString(GLenum name)
+  {
+    const GLubyte* str = glGetString(name);
+    return str ? reinterpret_cast<const char*>(str) : "";
+  }
+}
+
+ProgramCache::ProgramCache(std::string directory) :
+  m_directory{ std::move(directory) }
+{
+}
+
+void ProgramCache::Initialise()
+{
+  if (m_initialised)
+    return;
+  m_initialised = true;
+
+  m_driver = GetString(GL_VENDOR) + "\n" + GetString(GL_RENDERER) + "\n" + GetString(GL_VERSION);
+
+  GLint formats = 0;
+  if (GLEW_ARB_get_program_binary)
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  m_supported = formats > 0;
+  if (!m_supported)
+    Logger::GetInstance()->Log("Program binaries are not supported, shaders are built from source every run");
+}
+
+std::string ProgramCache::GetPath(uint64_t key) const
+{
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+  return m_directory + name;
+}
+
+bool ProgramCache::IsSupported()
+{
+  Initialise();
+  return m_supported;
+}
+
+uint64_t ProgramCache::GetKey(const std::vector<std::string_view>& sources)
+{
+  Initialise();
+  uint64_t hash = Hash(FnvOffset, &CacheVersion, sizeof(CacheVersion));
+  hash = Hash(hash, m_driver);
+  for (std::string_view source : sources)
+    hash = Hash(hash, source);
+  return hash;
+}
+
+bool ProgramCache::Load(uint64_t key, GLuint program)
+{
+  if (!IsSupported())
+    return false;
+
+  std::ifstream file(GetPath(key), std::ios::binary);
+  if (!file)
+    return false;
+
+  CacheHeader header{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!file || header.magic != CacheMagic || header.version != CacheVersion || header.key != key)
+    return false;
+
+  std::vector<char> binary(header.size);
+  file.read(binary.data(), binary.size());
+  if (!file)
+    return false;
+
+  glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+  GLint linked = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  return linked != 0;
+}
+
+bool ProgramCache::Store(uint64_t key, GLuint program)
+{
+  if (!IsSupported())
+    return false;
+
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return false;
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+
+  std::error_code error;
+  std::filesystem::create_directories(m_directory, error);
+
+  std::ofstream file(GetPath(key), std::ios::binary | std::ios::trunc);
+  if (!file)
+  {
+    Logger::GetInstance()->Log("Could not write program binary " + GetPath(key));
+    return false;
+  }
+
+  CacheHeader header{ CacheMagic, CacheVersion, key, format, static_cast<uint32_t>(length) };
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(binary.data(), length);
+  return file.good();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#define GLEW_STATIC
+#include "glew/glew.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Engine
+{
+  namespace Rendering
+  {
+    /*
+    linked programs saved with glGetProgramBinary so the next run skips compiling and linking
+    entries are keyed by the sources and the driver that built them, a driver update or an edited
+    shader simply misses and the program is built from source and stored again
+    */
+    class ProgramCache
+    {
+      std::string m_directory;
+      // vendor, renderer and version, binaries only load on the driver that wrote them
+      std::string m_driver;
+      bool m_initialised = false;
+      bool m_supported = false;
+
+      void Initialise();
+      std::string GetPath(uint64_t key) const;
+
+    public:
+      explicit ProgramCache(std::string directory = "ShaderCache/");
+
+      // needs the context, false if the driver cannot hand out program binaries
+      bool IsSupported();
+
+      // the key of a program built from sources, in the order they are attached
+      uint64_t GetKey(const std::vector<std::string_view>& sources);
+
+      // loads the binary stored under key into program and checks it linked,
+      // false if there is none or the driver rejected it, program can still be built from source then
+      bool Load(uint64_t key, GLuint program);
+
+      // saves the linked program under key, the program needs GL_PROGRAM_BINARY_RETRIEVABLE_HINT set before linking
+      bool Store(uint64_t key, GLuint program);
+    };
+  }
+}
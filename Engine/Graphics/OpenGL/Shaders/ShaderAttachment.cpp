@@ -22,7 +22,8 @@ ShaderAttachment::ShaderAttachment(ShaderType type, std::string filename):
   m_shaderID { 0 },
   m_type {type},
   m_source { },
-  m_filename { SHADER_RELATIVE_PATH + filename }
+  m_filename { SHADER_RELATIVE_PATH + filename },
+  m_sourceSet { false }
 {
 
 }
@@ -32,12 +33,13 @@ GLuint ShaderAttachment::GetShaderID()
   return m_shaderID;
 }
 
-bool ShaderAttachment::Setup()
+void ShaderAttachment::ReadSource()
 {
-  GLenum glErr;
-  GLint compiled = 0;
-  glErr = glGetError(); // clear error cache
-  GLuint oldProg = m_shaderID;
+  if (m_sourceSet)
+  {
+    m_sourceSet = false;
+    return;
+  }
 
   if (m_filename != "")
   {
@@ -54,6 +56,36 @@ bool ShaderAttachment::Setup()
 
     fs.close();
   }
+}
+
+void ShaderAttachment::SetSource(std::string source)
+{
+  m_source = std::move(source);
+  m_sourceSet = true;
+}
+
+const std::string& ShaderAttachment::GetSource() const
+{
+  return m_source;
+}
+
+const std::string& ShaderAttachment::GetFilename() const
+{
+  return m_filename;
+}
+
+bool ShaderAttachment::Setup()
+{
+  ReadSource();
+  return Compile();
+}
+
+bool ShaderAttachment::Compile()
+{
+  GLenum glErr;
+  GLint compiled = 0;
+  glErr = glGetError(); // clear error cache
+  GLuint oldProg = m_shaderID;
 
   const char* src = m_source.c_str();
 
@@ -35,11 +35,21 @@ class ShaderAttachment
   ShaderType m_type;
   std::string m_source;
   std::string m_filename;
+  // set by SetSource, the next ReadSource keeps it instead of reading the file
+  bool m_sourceSet;
 
 public:
   ShaderAttachment(ShaderType type, std::string filename);
   GLuint GetShaderID();
+  // reads the file into the source, Setup does it as well
+  void ReadSource();
+  // for callers that already read the file
+  void SetSource(std::string source);
+  const std::string& GetSource() const;
+  const std::string& GetFilename() const;
   bool Setup();//shaders code inside
+  // compiles the source as it is, without reading the file again
+  bool Compile();
   void Clean(GLuint programID);
 
 
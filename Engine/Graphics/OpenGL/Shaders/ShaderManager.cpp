@@ -20,6 +20,9 @@ Which is meant to handle shader management, such as distributing of shaders from
 #include <functional>
 #include "Graphics/Sprite/Sprite.h"
 #include "BasicShader.h"
+#include "Logger.h"
+#include <chrono>
+#include <thread>
 
 
 
@@ -29,35 +32,28 @@ using Filename = GraphicsSystem_OpenGL::Filename;
 
 ShaderPtr GraphicsSystem_OpenGL::ShaderManager::GetShader(ShaderName name) const
 {
-  try
-  {
-    return m_shaderMap.at(name);
-  }
-  catch (std::out_of_range)
-  {
-    return ShaderPtr{};
-  }
+  std::lock_guard<std::mutex> lock(m_shaderLock);
+  auto itr = m_shaderMap.find(name);
+  return itr != m_shaderMap.end() ? itr->second : ShaderPtr{};
 }
 
 ShaderPtr GraphicsSystem_OpenGL::ShaderManager::LoadShader(Filename vertexSource,
   Filename fragmentSource, ShaderName name, std::vector<ShaderAttachment> attachmentList)
 {
   LoadShaderNoRet(vertexSource, fragmentSource, name, attachmentList);
-  return m_shaderMap.at(name);
+  // the caller gets a shader it can use straight away
+  FinishPendingShaders();
+  return GetShader(name);
 }
 
 void GraphicsSystem_OpenGL::ShaderManager::LoadShaderNoRet(Filename vertexSource, 
   Filename fragmentSource, ShaderName name, std::vector<ShaderAttachment> attachmentList)
 {
   ShaderProg shader;
-  try
-  {
-    shader = m_shaderMap.at(name)->GetProgram();
-  }
-  catch (std::out_of_range)
-  {
+  if (ShaderPtr existing = GetShader(name))
+    shader = existing->GetProgram();
+  else
     shader = std::make_shared<ShaderProgram>();
-  }
 	if(vertexSource != "")
 	  shader->m_vertexFile = (SHADER_RELATIVE_PATH + vertexSource).c_str();
 	else
@@ -72,16 +68,12 @@ void GraphicsSystem_OpenGL::ShaderManager::LoadShaderNoRet(Filename vertexSource
     shader->RegisterAttachment(attachment);
   }
 
-  // if shader fails then so be it
-  if (shader->Setup())
-  {
-    std::string temp;
-    temp = name;
-    temp += " Loaded";
-    //INF_CORE_INFO(temp);
-  }
-
   shader->SetShaderName(name);
+  TrackDependencies(name, shader);
+
+  // if shader fails then so be it, FinishPendingShaders logs why
+  if (shader->BeginSetup(&m_programCache))
+    m_pendingShaders.push_back(shader);
 
   RegisterShader(std::make_shared<BasicShader>(shader), name);
 }
@@ -89,6 +81,7 @@ void GraphicsSystem_OpenGL::ShaderManager::LoadShaderNoRet(Filename vertexSource
 
 void GraphicsSystem_OpenGL::ShaderManager::RegisterShader(ShaderPtr shader, ShaderName name)
 {
+  std::lock_guard<std::mutex> lock(m_shaderLock);
   m_shaderMap[name] = shader;
   m_reverseMap[shader] = name;
 }
@@ -96,6 +89,9 @@ void GraphicsSystem_OpenGL::ShaderManager::RegisterShader(ShaderPtr shader, Shad
 
 GraphicsSystem_OpenGL::ShaderManager::~ShaderManager()
 {
+  m_watcher.reset();
+
+  std::lock_guard<std::mutex> lock(m_shaderLock);
   std::for_each(begin(m_shaderMap), end(m_shaderMap), [](std::pair<ShaderName, ShaderPtr> shader)
     {
       shader.second->GetProgram()->Clean();
@@ -107,16 +103,164 @@ GraphicsSystem_OpenGL::ShaderManager::~ShaderManager()
 
 void GraphicsSystem_OpenGL::ShaderManager::ReloadShaders()
 {
-  std::for_each(std::begin(m_shaderMap), std::end(m_shaderMap),
-    [](std::pair<ShaderName, ShaderPtr> shader)
+  std::vector<ShaderProg> programs;
+  {
+    std::lock_guard<std::mutex> lock(m_shaderLock);
+    for (auto& [name, shader] : m_shaderMap)
+      programs.push_back(shader->GetProgram());
+  }
+
+  // every build is started before any is waited on
+  for (ShaderProg& program : programs)
+  {
+    if (program->BeginSetup(&m_programCache))
+      m_pendingShaders.push_back(program);
+  }
+  FinishPendingShaders();
+}
+
+void GraphicsSystem_OpenGL::ShaderManager::FinishPendingShaders()
+{
+  for (ShaderProg& shader : m_pendingShaders)
+  {
+    if (shader->FinishSetup())
+    {
+      std::string log = "built shader ";
+      log += shader->GetShaderName();
+      //INF_CORE_INFO(log);
+    }
+  }
+  m_pendingShaders.clear();
+}
+
+void GraphicsSystem_OpenGL::ShaderManager::TrackDependencies(const ShaderName& name, const ShaderProg& shader)
+{
+  std::vector<std::string> files{ shader->m_vertexFile, shader->m_fragmentFile };
+  for (auto& attachment : shader->m_attachmentList)
+    files.push_back(attachment.GetFilename());
+
+  std::lock_guard<std::mutex> lock(m_changeLock);
+  // loading a shader again under the same name may build it from other files
+  for (auto& [file, names] : m_dependencies)
+    names.erase(name);
+  for (auto& file : files)
+  {
+    if (!file.empty())
+      m_dependencies[Engine::Files::FileWatcher::Normalise(file)].insert(name);
+  }
+}
+
+void GraphicsSystem_OpenGL::ShaderManager::OnFileChanged(const std::string& path)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_changeLock);
+    if (m_dependencies.find(path) == m_dependencies.end())
+      return;
+  }
+
+  // the editor can still be holding the file when the change comes in
+  std::string source;
+  for (int attempt = 0; attempt < 10 && source.empty(); ++attempt)
+  {
+    std::ifstream fs(path);
+    if (fs.good())
     {
-      if (shader.second->GetProgram()->Setup())
+      std::stringstream ss;
+      ss << fs.rdbuf();
+      source = ss.str();
+    }
+    if (source.empty())
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (source.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock(m_changeLock);
+  m_changedFiles[path] = std::move(source);
+}
+
+bool GraphicsSystem_OpenGL::ShaderManager::WatchShaders(const std::string& directory)
+{
+  if (!m_watcher)
+  {
+    m_watcher = std::make_unique<Engine::Files::FileWatcher>([this](const std::string& path)
       {
-        std::string log = "built shader ";
-        log += shader.first;
-        //INF_CORE_INFO(log);
-      }
+        OnFileChanged(path);
+      });
+  }
+
+  // directories can only be added while it is stopped
+  m_watcher->Stop();
+  bool watching = m_watcher->Watch(directory);
+  m_watcher->Start();
+  return watching;
+}
+
+void GraphicsSystem_OpenGL::ShaderManager::StopWatchingShaders()
+{
+  if (m_watcher)
+    m_watcher->Stop();
+}
+
+void GraphicsSystem_OpenGL::ShaderManager::ApplyShaderChanges()
+{
+  // rebuilds the driver is still busy with get another frame
+  auto done = std::remove_if(m_reloadingShaders.begin(), m_reloadingShaders.end(), [](const ShaderProg& shader)
+    {
+      // finished by FinishPendingShaders when it was loaded again meanwhile
+      if (!shader->IsSetupPending())
+        return true;
+      if (!shader->IsSetupComplete())
+        return false;
+      if (shader->FinishSetup())
+        Logger::GetInstance()->Log("Reloaded shader " + shader->GetShaderName());
+      return true;
     });
+  m_reloadingShaders.erase(done, m_reloadingShaders.end());
+
+  std::map<std::string, std::string> changed;
+  std::set<ShaderName> affected;
+  {
+    std::lock_guard<std::mutex> lock(m_changeLock);
+    if (m_changedFiles.empty())
+      return;
+    changed.swap(m_changedFiles);
+    for (auto& [file, source] : changed)
+    {
+      auto itr = m_dependencies.find(file);
+      if (itr != m_dependencies.end())
+        affected.insert(itr->second.begin(), itr->second.end());
+    }
+  }
+
+  auto findSource = [&changed](const std::string& file) -> const std::string*
+  {
+    auto itr = changed.find(Engine::Files::FileWatcher::Normalise(file));
+    return itr != changed.end() ? &itr->second : nullptr;
+  };
+
+  for (const ShaderName& name : affected)
+  {
+    ShaderPtr found = GetShader(name);
+    if (!found)
+      continue;
+
+    // only the files that changed are replaced, the rest are read again as usual
+    ShaderProg shader = found->GetProgram();
+    if (const std::string* source = findSource(shader->m_vertexFile))
+      shader->SetVertexSource(*source);
+    if (const std::string* source = findSource(shader->m_fragmentFile))
+      shader->SetFragmentSource(*source);
+    for (auto& attachment : shader->m_attachmentList)
+    {
+      if (const std::string* source = findSource(attachment.GetFilename()))
+        attachment.SetSource(*source);
+    }
+
+    if (shader->BeginSetup(&m_programCache) &&
+      std::find(m_reloadingShaders.begin(), m_reloadingShaders.end(), shader) == m_reloadingShaders.end())
+      m_reloadingShaders.push_back(shader);
+  }
 }
 
 void GraphicsSystem_OpenGL::ShaderManager::CreateUniformBuffer(UniformBuffer::UniformName name)
@@ -131,6 +275,12 @@ void GraphicsSystem_OpenGL::ShaderManager::CreateUniformBuffer(UniformBuffer::Un
 
 void GraphicsSystem_OpenGL::ShaderManager::InitBasicShaders()
 {
+  // lets the driver compile and link on its own threads, link status is only read in FinishPendingShaders
+  if (GLEW_KHR_parallel_shader_compile)
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+  else if (GLEW_ARB_parallel_shader_compile)
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
   //LoadShaderNoRet("BatchVertexShader.glsl", "BatchFragmentShader.glsl", "default");
 }
 
@@ -150,6 +300,7 @@ void GraphicsSystem_OpenGL::ShaderManager::SetUniformBufferData(UniformBuffer::U
 
 std::string  GraphicsSystem_OpenGL::ShaderManager::GetName(ShaderPtr shader)
 {
+  std::lock_guard<std::mutex> lock(m_shaderLock);
   auto itr = std::find_if(std::begin(m_reverseMap), std::end(m_reverseMap), [&shader](auto it)
     {
       return ((static_cast<ShaderPtr>(it.first)->GetProgramId()) == shader->GetProgramId());
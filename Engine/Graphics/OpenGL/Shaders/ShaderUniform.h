@@ -0,0 +1,94 @@
+#pragma once
+#define GLEW_STATIC
+#include "glew/glew.h"
+#include "glm/glm/glm.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// FNV-1a, uniforms are looked up by this so names are only hashed once
+constexpr uint32_t HashUniformName(std::string_view name)
+{
+  uint32_t hash = 2166136261u;
+  for (char c : name)
+  {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// what reflection found for one active uniform after linking
+struct UniformInfo
+{
+  uint32_t hash;
+  GLint location;
+  GLenum type;
+  // element count for arrays, 1 otherwise
+  GLint size;
+  // arrays are stored without the trailing [0]
+  std::string name;
+};
+
+struct UniformBlockInfo
+{
+  uint32_t hash;
+  GLuint index;
+  GLint dataSize;
+  GLint binding;
+  std::string name;
+};
+
+namespace UniformDetails
+{
+  // the GL types a C++ type may be set on
+  template<typename T>
+  constexpr bool MatchesType(GLenum type);
+
+  template<> constexpr bool MatchesType<float>(GLenum type) { return type == GL_FLOAT; }
+  template<> constexpr bool MatchesType<glm::vec2>(GLenum type) { return type == GL_FLOAT_VEC2; }
+  template<> constexpr bool MatchesType<glm::vec3>(GLenum type) { return type == GL_FLOAT_VEC3; }
+  template<> constexpr bool MatchesType<glm::vec4>(GLenum type) { return type == GL_FLOAT_VEC4; }
+  template<> constexpr bool MatchesType<glm::mat3>(GLenum type) { return type == GL_FLOAT_MAT3; }
+  template<> constexpr bool MatchesType<glm::mat4>(GLenum type) { return type == GL_FLOAT_MAT4; }
+  // samplers are set with the texture unit
+  template<> constexpr bool MatchesType<int>(GLenum type)
+  {
+    return type == GL_INT || type == GL_BOOL ||
+      type == GL_SAMPLER_2D || type == GL_SAMPLER_3D || type == GL_SAMPLER_CUBE || type == GL_SAMPLER_2D_ARRAY;
+  }
+
+  // one GL call each, the program does not have to be bound
+  inline void Upload(GLuint program, GLint location, float value) { glProgramUniform1f(program, location, value); }
+  inline void Upload(GLuint program, GLint location, int value) { glProgramUniform1i(program, location, value); }
+  inline void Upload(GLuint program, GLint location, const glm::vec2& value) { glProgramUniform2fv(program, location, 1, &value[0]); }
+  inline void Upload(GLuint program, GLint location, const glm::vec3& value) { glProgramUniform3fv(program, location, 1, &value[0]); }
+  inline void Upload(GLuint program, GLint location, const glm::vec4& value) { glProgramUniform4fv(program, location, 1, &value[0]); }
+  inline void Upload(GLuint program, GLint location, const glm::mat3& value) { glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, &value[0][0]); }
+  inline void Upload(GLuint program, GLint location, const glm::mat4& value) { glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, &value[0][0]); }
+}
+
+/*
+a uniform of type T, the name is hashed where the handle is declared
+the location is resolved the first time it is set on a program and kept until
+a different program or a relink of the same one is seen, so setting it every draw
+costs an integer compare and one GL call
+*/
+template<typename T>
+struct UniformHandle
+{
+  uint32_t hash = 0;
+  std::string_view name;
+
+  // -1 when the program has no such uniform or it is of another type
+  GLint location = -1;
+  // ShaderProgram::GetLinkID of the program location was resolved for, 0 is never used
+  uint32_t linkID = 0;
+
+  constexpr UniformHandle() = default;
+  constexpr UniformHandle(std::string_view uniformName) :
+    hash{ HashUniformName(uniformName) },
+    name{ uniformName }
+  {
+  }
+};
@@ -0,0 +1,51 @@
+#include "UniformArena.h"
+#include <cassert>
+#include <cstring>
+
+using namespace Engine::Rendering;
+
+size_t UniformArena::GetAlignment()
+{
+  if (!m_alignment)
+  {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    // the spec caps it at 256
+    m_alignment = alignment > 0 ? static_cast<size_t>(alignment) : 256;
+  }
+  return m_alignment;
+}
+
+size_t UniformArena::GetFootprint(size_t size)
+{
+  return size + GetAlignment() - 1;
+}
+
+void UniformArena::Begin(StreamBuffer& stream)
+{
+  m_stream = &stream;
+}
+
+UniformArena::Block UniformArena::Push(const void* data, size_t size)
+{
+  if (!m_stream)
+    return {};
+
+  StreamBuffer::Allocation allocation = m_stream->Allocate(size, GetAlignment());
+  if (!allocation.data)
+    return {};
+  // glBindBufferRange rejects anything else with GL_INVALID_VALUE and leaves the binding as it was
+  assert(allocation.offset % GetAlignment() == 0);
+  if (allocation.offset % GetAlignment() != 0)
+    return {};
+  std::memcpy(allocation.data, data, size);
+  return Block{ m_stream->GetBuffer(), allocation.offset, static_cast<GLsizeiptr>(size) };
+}
+
+bool UniformArena::Bind(GLuint binding, const Block& block)
+{
+  if (!block.buffer)
+    return false;
+  glBindBufferRange(GL_UNIFORM_BUFFER, binding, block.buffer, block.offset, block.size);
+  return true;
+}
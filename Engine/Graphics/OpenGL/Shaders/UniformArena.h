@@ -0,0 +1,67 @@
+#pragma once
+#define GLEW_STATIC
+#include "glew/glew.h"
+#include "glm/glm/glm.hpp"
+#include "ShaderUniform.h"
+#include "../GraphicsCore/StreamBuffer.h"
+#include <cstddef>
+
+namespace Engine
+{
+  namespace Rendering
+  {
+    // set once a frame and read by every shader that declares
+    // layout(std140) uniform FrameData { mat4 worldTrans; };
+    struct FrameData
+    {
+      glm::mat4 worldTrans;
+    };
+
+    // FrameData is always bound to 0, ShaderManager's named buffers start after it
+    constexpr GLuint FrameDataBinding = 0;
+    constexpr GLuint FirstSharedBinding = 1;
+    constexpr std::string_view FrameDataName = "FrameData";
+    constexpr uint32_t FrameDataHash = HashUniformName(FrameDataName);
+
+    /*
+    hands out uniform blocks from the frame's region of the stream buffer
+    every block starts on GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT so it can be bound on its own,
+    blocks live until the frame ends and are never freed one by one
+    */
+    class UniformArena
+    {
+    public:
+      struct Block
+      {
+        // 0 if the block did not fit
+        GLuint buffer = 0;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+      };
+
+    private:
+      StreamBuffer* m_stream = nullptr;
+      size_t m_alignment = 0;
+
+      size_t GetAlignment();
+
+    public:
+      // stream space a block of size bytes can take up at most, needs the context to be current
+      size_t GetFootprint(size_t size);
+
+      // blocks come out of stream until the next Begin, call between its BeginFrame and Commit
+      void Begin(StreamBuffer& stream);
+
+      Block Push(const void* data, size_t size);
+
+      template<typename T>
+      Block Push(const T& data)
+      {
+        return Push(&data, sizeof(T));
+      }
+
+      // binds the block's range to binding, false if the block is empty
+      static bool Bind(GLuint binding, const Block& block);
+    };
+  }
+}
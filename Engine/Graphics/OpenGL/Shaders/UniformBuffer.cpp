@@ -15,9 +15,12 @@ UniformBuffer::~UniformBuffer()
 void UniformBuffer::BindBuffer(shaderProg prog)
 {
   unsigned int bufferIndex = glGetUniformBlockIndex(prog, m_name.c_str());
+  if (bufferIndex == GL_INVALID_INDEX || !m_maxSize)
+    return;
   glUniformBlockBinding(prog, bufferIndex, static_cast<GLuint>(m_bindingPoint));
-  glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(m_bindingPoint), m_bufferID, 
-    static_cast<GLuint>(m_bindingPoint), static_cast<GLuint>(m_maxSize));
+  // the whole buffer, it only ever holds the one block
+  glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(m_bindingPoint), m_bufferID,
+    0, static_cast<GLsizeiptr>(m_maxSize));
 
 }
 
@@ -26,7 +29,7 @@ void UniformBuffer::SetBufferData(GLvoid* data, size_t size)
   glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
   if (m_maxSize < size)
   {
-    glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STATIC_DRAW);
+    glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
     m_maxSize = size;
   }
   else
@@ -35,11 +35,21 @@ Sprite::~Sprite()
   m_mesh.reset();
 }
 
+bool Sprite::operator==(const Sprite& rhs) const
+{
+  return m_shader == rhs.m_shader && m_mesh == rhs.m_mesh && m_textureID == rhs.m_textureID;
+}
+
+bool Sprite::operator!=(const Sprite& rhs) const
+{
+  return !(*this == rhs);
+}
+
 void Sprite::Draw()
 {
   //glBindTexture(GL_TEXTURE_2D, m_textureID);
   glBindVertexArray(m_mesh->VAOref);
-  glDrawElements(m_mesh->drawMode, static_cast<GLsizei>(m_mesh->IA.size()), GL_UNSIGNED_INT, 0);
+  glDrawElements(m_mesh->drawMode, m_mesh->indexCount, m_mesh->indexType, 0);
 }
 
 void Sprite::SetShader()
@@ -82,3 +92,21 @@ std::shared_ptr<Mesh> Sprite::GetMesh() const
 {
   return m_mesh;
 }
+
+void Sprite::Serialize(Engine::Snapshot::Writer& writer) const
+{
+  auto gs = GraphicsSystem_OpenGL::GetInstance();
+  writer.WriteString(m_shader ? GetShaderName() : "");
+  writer.WriteString(m_mesh ? gs->GetMeshName(m_mesh) : "");
+  writer.Write(m_textureID);
+}
+
+void Sprite::Deserialize(Engine::Snapshot::Reader& reader)
+{
+  auto gs = GraphicsSystem_OpenGL::GetInstance();
+  std::string shader = reader.ReadString();
+  std::string mesh = reader.ReadString();
+  m_shader = shader.empty() ? BasicShader::ShaderPtr{} : gs->ShaderMan.GetShader(shader);
+  m_mesh = mesh.empty() ? std::shared_ptr<Mesh>{} : gs->GetMesh(mesh);
+  m_textureID = reader.Read<TextureID>();
+}
@@ -26,6 +26,7 @@ which is used to hold and draw objects
 #include <functional>
 
 #include "SpriteHandler.h"
+#include "Snapshot.h"
 #include <string>
 
 class Sprite
@@ -36,10 +37,14 @@ public:
   BasicShader::ShaderPtr m_shader;
   std::shared_ptr<Mesh> m_mesh;
   
-  TextureID m_textureID;
+  TextureID m_textureID = 0;
 public:
   //SpriteShaderData m_shaderData;
 
+  // sprites are shared components, entities using the same
+  // shader, mesh and texture are grouped together in their archetype
+  static constexpr bool isSharedComponent = true;
+
   Sprite() = default;
   Sprite(Sprite && rhs) = default;
   Sprite(const Sprite & rhs) = default;
@@ -51,6 +56,9 @@ public:
   Sprite& operator=(Sprite&& rhs) = default;
   Sprite& operator=(const Sprite & rhs) = default;
 
+  bool operator==(const Sprite& rhs) const;
+  bool operator!=(const Sprite& rhs) const;
+
   void Draw();
   void SetShader();
 
@@ -66,6 +74,10 @@ public:
 
   std::shared_ptr<Mesh> GetMesh() const;
 
+  // shader and mesh are saved by name as their handles only mean something in this process
+  void Serialize(Engine::Snapshot::Writer& writer) const;
+  void Deserialize(Engine::Snapshot::Reader& reader);
+
   void Validate()
   {
     if (m_shader)
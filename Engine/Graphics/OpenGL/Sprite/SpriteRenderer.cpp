@@ -0,0 +1,84 @@
+#include "SpriteRenderer.h"
+#include <cstddef>
+#include <cstring>
+
+using namespace Engine::Rendering;
+
+static_assert(sizeof(SpriteInstance) == sizeof(float) * 20, "instances are uploaded without padding");
+
+size_t SpriteRenderer::GetUploadSize(const std::vector<SpriteInstance>& instances)
+{
+	return instances.size() * sizeof(SpriteInstance) + sizeof(SpriteInstance);
+}
+
+void SpriteRenderer::Upload(StreamBuffer& stream, const std::vector<SpriteInstance>& instances)
+{
+	m_instanceBuffer = 0;
+	if (instances.empty())
+		return;
+
+	StreamBuffer::Allocation allocation = stream.Allocate(instances.size() * sizeof(SpriteInstance), sizeof(SpriteInstance));
+	if (!allocation.data)
+		return;
+	std::memcpy(allocation.data, instances.data(), instances.size() * sizeof(SpriteInstance));
+	m_instanceBuffer = stream.GetBuffer();
+	m_instanceOffset = allocation.offset;
+}
+
+void SpriteRenderer::BindInstances(const Mesh& mesh, size_t first)
+{
+	m_state.BindVertexArray(mesh.VAOref);
+	m_state.BindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+	GLsizei stride = sizeof(SpriteInstance);
+	size_t offset = m_instanceOffset + first * sizeof(SpriteInstance);
+	// a mat4 attribute takes one location per column
+	for (GLuint column = 0; column < 4; ++column)
+	{
+		GLuint location = TransformLocation + column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride,
+			(GLvoid*)(offset + offsetof(SpriteInstance, transform) + sizeof(glm::vec4) * column));
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
+	}
+	glVertexAttribPointer(ColorLocation, 4, GL_FLOAT, GL_FALSE, stride,
+		(GLvoid*)(offset + offsetof(SpriteInstance, color)));
+	glVertexAttribDivisor(ColorLocation, 1);
+	glEnableVertexAttribArray(ColorLocation);
+}
+
+void SpriteRenderer::Draw(std::vector<SpriteBatch>& batches)
+{
+	if (!m_instanceBuffer)
+		return;
+
+	// anything may have been bound since the last frame
+	m_state.Invalidate();
+
+	m_queue.Clear();
+	for (uint32_t i = 0; i < batches.size(); ++i)
+	{
+		const Sprite& sprite = batches[i].sprite;
+		if (!batches[i].count || !sprite.m_shader || !sprite.m_mesh)
+			continue;
+		m_queue.Submit(MakeSortKey(batches[i].layer, sprite.m_shader->GetProgramId(), sprite.m_mesh->VAOref,
+			sprite.m_textureID, batches[i].depth), i);
+	}
+	m_queue.Sort();
+
+	for (const DrawQueue::Entry& entry : m_queue.GetEntries())
+	{
+		SpriteBatch& batch = batches[entry.index];
+		BasicShader& shader = *batch.sprite.m_shader;
+		const Mesh& mesh = *batch.sprite.m_mesh;
+
+		// block bindings belong to the program, so they only need checking when it changes
+		if (m_state.UseProgram(shader.GetProgramId()))
+			shader.GetProgram()->SetUniformBlockBinding(FrameDataHash, FrameDataName, FrameDataBinding);
+		m_state.BindTexture(0, batch.sprite.m_textureID);
+
+		BindInstances(mesh, batch.first);
+		glDrawElementsInstanced(mesh.drawMode, mesh.indexCount, mesh.indexType, 0,
+			static_cast<GLsizei>(batch.count));
+	}
+}
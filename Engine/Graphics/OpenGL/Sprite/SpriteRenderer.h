@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+
+#include "Sprite.h"
+#include "../DrawQueue.h"
+#include "../GraphicsCore/StateCache.h"
+#include "../GraphicsCore/StreamBuffer.h"
+#include "../Shaders/UniformArena.h"
+#include "glew/glew.h"
+#include "glm/glm/glm.hpp"
+
+namespace Engine
+{
+	namespace Rendering
+	{
+		// uploaded as is, one per sprite drawn
+		struct SpriteInstance
+		{
+			glm::mat4 transform;
+			glm::vec4 color;
+		};
+
+		// instances [first, first + count) are drawn with sprite
+		struct SpriteBatch
+		{
+			// a copy so the shader and mesh stay alive while the frame is drawn
+			Sprite sprite;
+			size_t first = 0;
+			size_t count = 0;
+			// lower layers are drawn first, depth orders batches that share everything else
+			uint8_t layer = 0;
+			uint16_t depth = 0;
+		};
+
+		/*
+		draws every batch with a single glDrawElementsInstanced
+		all instances of a frame are written into the stream buffer in one go,
+		each batch then points the mesh's instance attributes at its own range of it
+		batches are sorted by layer, shader, mesh and texture and bound through a state cache,
+		so neighbouring batches only change what actually differs
+		sprite shaders read the transform from attribute locations 3 to 6 and the colour from 7,
+		and worldTrans from the FrameData block, so no uniforms are set per batch
+		*/
+		class SpriteRenderer
+		{
+		public:
+			static constexpr GLuint TransformLocation = 3;
+			static constexpr GLuint ColorLocation = 7;
+
+		private:
+			// where this frame's instances were written, 0 if they did not fit
+			GLuint m_instanceBuffer = 0;
+			GLintptr m_instanceOffset = 0;
+			StateCache m_state;
+			DrawQueue m_queue;
+
+			void BindInstances(const Mesh& mesh, size_t first);
+
+		public:
+			SpriteRenderer() = default;
+			SpriteRenderer(const SpriteRenderer&) = delete;
+			SpriteRenderer& operator=(const SpriteRenderer&) = delete;
+
+			// bytes Upload takes out of the stream buffer
+			static size_t GetUploadSize(const std::vector<SpriteInstance>& instances);
+
+			// writes the frame's instances, between the stream's BeginFrame and Commit
+			void Upload(StreamBuffer& stream, const std::vector<SpriteInstance>& instances);
+			// after the stream has been committed and FrameData bound, needs the context to be current
+			void Draw(std::vector<SpriteBatch>& batches);
+		};
+	}
+}
@@ -0,0 +1,296 @@
+#include "Hierarchy.h"
+#include "EntityManager.h"
+#include "JobSystem.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <string>
+
+using namespace Engine::Hierarchy;
+
+namespace
+{
+	// levels smaller than this are not worth handing to other threads,
+	// and no job gets fewer nodes than this either
+	constexpr uint32_t ParallelLevelThreshold = 2048;
+	constexpr size_t NodesPerJob = 1024;
+	// marks the nodes of the chain being walked while depths are worked out
+	constexpr uint32_t OnChain = HierarchyManager::InvalidSlot - 1;
+
+	bool SameEntity(Entity lhs, Entity rhs)
+	{
+		// the zombie flag gets toggled on the handle when an entity is queued for deletion
+		return ((lhs ^ rhs) & ~Engine::EntityManager::ZombieMask) == 0;
+	}
+}
+
+Transform2D Engine::Hierarchy::Combine(const Transform2D& parent, const Transform2D& local)
+{
+	float c = std::cos(parent.rotation);
+	float s = std::sin(parent.rotation);
+	float lx = local.x * parent.scale;
+	float ly = local.y * parent.scale;
+
+	Transform2D world;
+	world.x = parent.x + c * lx - s * ly;
+	world.y = parent.y + s * lx + c * ly;
+	world.rotation = parent.rotation + local.rotation;
+	world.scale = parent.scale * local.scale;
+	return world;
+}
+
+uint32_t& HierarchyManager::SlotOf(Entity entity)
+{
+	size_t index = EntityManager::EntityHelper::ExtractIndex(entity);
+	if (index >= m_slotOf.size())
+		m_slotOf.resize(index + 1, InvalidSlot);
+	return m_slotOf[index];
+}
+
+uint32_t HierarchyManager::FindSlot(Entity entity) const
+{
+	size_t index = EntityManager::EntityHelper::ExtractIndex(entity);
+	if (index >= m_slotOf.size())
+		return InvalidSlot;
+	uint32_t slot = m_slotOf[index];
+	if (slot == InvalidSlot || !SameEntity(m_entities[slot], entity))
+		return InvalidSlot;
+	return slot;
+}
+
+void HierarchyManager::Add(Entity entity, Entity parent, const Transform2D& local)
+{
+	assert(!Contains(entity));
+	assert(parent == NoParent || Contains(parent));
+
+	SlotOf(entity) = static_cast<uint32_t>(m_entities.size());
+	m_entities.push_back(entity);
+	m_parents.push_back(parent);
+	m_parentSlots.push_back(InvalidSlot);
+	m_local.push_back(local);
+	// best guess until the next propagate
+	m_world.push_back(local);
+	m_dirty = true;
+}
+
+void HierarchyManager::Remove(Entity entity)
+{
+	uint32_t slot = FindSlot(entity);
+	if (slot == InvalidSlot)
+		return;
+
+	// swap and pop, the children are left pointing at a parent that
+	// no longer exists and get turned into roots when the order is rebuilt
+	uint32_t last = static_cast<uint32_t>(m_entities.size() - 1);
+	if (slot != last)
+	{
+		m_entities[slot] = m_entities[last];
+		m_parents[slot] = m_parents[last];
+		m_local[slot] = m_local[last];
+		m_world[slot] = m_world[last];
+		SlotOf(m_entities[slot]) = slot;
+	}
+	m_entities.pop_back();
+	m_parents.pop_back();
+	m_parentSlots.pop_back();
+	m_local.pop_back();
+	m_world.pop_back();
+
+	m_slotOf[EntityManager::EntityHelper::ExtractIndex(entity)] = InvalidSlot;
+	m_dirty = true;
+}
+
+bool HierarchyManager::SetParent(Entity entity, Entity parent)
+{
+	uint32_t slot = FindSlot(entity);
+	assert(slot != InvalidSlot);
+	if (parent != NoParent && !Contains(parent))
+	{
+		Logger::GetInstance()->Log("Hierarchy: parent " + std::to_string(parent) + " is not in the hierarchy\n");
+		return false;
+	}
+
+	// parenting to one of our own descendants would make a cycle,
+	// ancestors that were removed since the last rebuild end the walk as they will become roots
+	for (uint32_t p = parent == NoParent ? InvalidSlot : FindSlot(parent); p != InvalidSlot;
+		p = m_parents[p] == NoParent ? InvalidSlot : FindSlot(m_parents[p]))
+	{
+		if (p == slot)
+		{
+			Logger::GetInstance()->Log("Hierarchy: " + std::to_string(parent) + " is a descendant of " +
+				std::to_string(entity) + ", it cannot become its parent\n");
+			return false;
+		}
+	}
+
+	m_parents[slot] = parent;
+	m_dirty = true;
+	return true;
+}
+
+bool HierarchyManager::Contains(Entity entity) const
+{
+	return FindSlot(entity) != InvalidSlot;
+}
+
+Entity HierarchyManager::GetParent(Entity entity) const
+{
+	uint32_t slot = FindSlot(entity);
+	assert(slot != InvalidSlot);
+	return m_parents[slot];
+}
+
+Transform2D& HierarchyManager::GetLocal(Entity entity)
+{
+	uint32_t slot = FindSlot(entity);
+	assert(slot != InvalidSlot);
+	return m_local[slot];
+}
+
+void HierarchyManager::SetLocal(Entity entity, const Transform2D& local)
+{
+	GetLocal(entity) = local;
+}
+
+const Transform2D& HierarchyManager::GetWorld(Entity entity) const
+{
+	uint32_t slot = FindSlot(entity);
+	assert(slot != InvalidSlot);
+	return m_world[slot];
+}
+
+size_t HierarchyManager::GetSize() const
+{
+	return m_entities.size();
+}
+
+void HierarchyManager::RebuildOrder()
+{
+	const uint32_t count = static_cast<uint32_t>(m_entities.size());
+
+	// parents that were removed leave their children as roots where they last were
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (m_parents[i] != NoParent && FindSlot(m_parents[i]) == InvalidSlot)
+		{
+			m_local[i] = m_world[i];
+			m_parents[i] = NoParent;
+		}
+	}
+
+	// work out the depth of every node, walking up until a known depth is hit
+	std::vector<uint32_t> depth(count, InvalidSlot);
+	std::vector<uint32_t> chain;
+	uint32_t maxDepth = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t slot = i;
+		while (depth[slot] == InvalidSlot)
+		{
+			if (m_parents[slot] == NoParent)
+			{
+				depth[slot] = 0;
+				break;
+			}
+			depth[slot] = OnChain;
+			chain.push_back(slot);
+			slot = FindSlot(m_parents[slot]);
+		}
+		if (depth[slot] == OnChain)
+		{
+			// SetParent refuses cycles, but one would hang this loop so it is broken up here as well,
+			// the node it was found at becomes a root and the walk starts over
+			Logger::GetInstance()->Log("Hierarchy: cycle through " + std::to_string(m_entities[slot]) + " broken\n");
+			m_local[slot] = m_world[slot];
+			m_parents[slot] = NoParent;
+			for (uint32_t c : chain)
+				depth[c] = InvalidSlot;
+			chain.clear();
+			--i;
+			continue;
+		}
+		uint32_t d = depth[slot];
+		while (!chain.empty())
+		{
+			depth[chain.back()] = ++d;
+			chain.pop_back();
+		}
+		maxDepth = std::max(maxDepth, depth[i]);
+	}
+
+	// counting sort by depth, stable so siblings keep their relative order
+	m_levelStart.assign(maxDepth + 2, 0);
+	for (uint32_t i = 0; i < count; ++i)
+		++m_levelStart[depth[i] + 1];
+	for (uint32_t d = 1; d < m_levelStart.size(); ++d)
+		m_levelStart[d] += m_levelStart[d - 1];
+
+	std::vector<uint32_t> newSlot(count);
+	{
+		std::vector<uint32_t> cursor(m_levelStart.begin(), m_levelStart.end() - 1);
+		for (uint32_t i = 0; i < count; ++i)
+			newSlot[i] = cursor[depth[i]]++;
+	}
+
+	std::vector<Entity> entities(count);
+	std::vector<Entity> parents(count);
+	std::vector<Transform2D> local(count);
+	std::vector<Transform2D> world(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t slot = newSlot[i];
+		entities[slot] = m_entities[i];
+		parents[slot] = m_parents[i];
+		local[slot] = m_local[i];
+		world[slot] = m_world[i];
+	}
+	m_entities.swap(entities);
+	m_parents.swap(parents);
+	m_local.swap(local);
+	m_world.swap(world);
+
+	for (uint32_t i = 0; i < count; ++i)
+		m_slotOf[EntityManager::EntityHelper::ExtractIndex(m_entities[i])] = i;
+
+	m_parentSlots.resize(count);
+	for (uint32_t i = 0; i < count; ++i)
+		m_parentSlots[i] = m_parents[i] == NoParent ? InvalidSlot : FindSlot(m_parents[i]);
+
+	m_dirty = false;
+}
+
+void HierarchyManager::PropagateLevel(uint32_t begin, uint32_t end)
+{
+	// parents all live in earlier levels which are already done
+	auto update = [this, begin](size_t first, size_t last)
+	{
+		for (size_t slot = begin + first; slot < begin + last; ++slot)
+			m_world[slot] = Combine(m_world[m_parentSlots[slot]], m_local[slot]);
+	};
+
+	size_t count = end - begin;
+	if (count >= ParallelLevelThreshold)
+	{
+		auto* jobs = Jobs::JobSystem::GetInstance();
+		size_t grain = std::max(count / (jobs->GetWorkerCount() * 4), NodesPerJob);
+		jobs->ParallelFor(count, grain, update);
+	}
+	else
+		update(0, count);
+}
+
+void HierarchyManager::Propagate()
+{
+	if (m_dirty)
+		RebuildOrder();
+
+	if (m_levelStart.size() < 2)
+		return;
+
+	// roots have nothing above them
+	std::copy(m_local.begin(), m_local.begin() + m_levelStart[1], m_world.begin());
+
+	for (size_t d = 1; d + 1 < m_levelStart.size(); ++d)
+		PropagateLevel(m_levelStart[d], m_levelStart[d + 1]);
+}
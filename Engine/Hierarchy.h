@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Entity.h"
+
+namespace Engine
+{
+	namespace Hierarchy
+	{
+		struct Transform2D
+		{
+			float x = 0;
+			float y = 0;
+			float rotation = 0;
+			float scale = 1;
+		};
+
+		// applies local on top of parent, giving local's transform in parent's space
+		Transform2D Combine(const Transform2D& parent, const Transform2D& local);
+
+		/*
+		owns the local and world transforms of every entity in a parent/child tree
+		nodes are kept sorted by depth so all parents come before their children,
+		that way world transforms are propagated in a single linear pass over the arrays
+		and every node within a depth level can be computed in parallel
+		structural changes only mark the order dirty, it is rebuilt on the next Propagate
+		*/
+		class HierarchyManager
+		{
+		public:
+			static constexpr uint32_t InvalidSlot = ~0u;
+			static constexpr Entity NoParent = 0;
+
+		private:
+			// struct of arrays indexed by slot
+			std::vector<Entity> m_entities;
+			std::vector<Entity> m_parents;
+			std::vector<uint32_t> m_parentSlots;
+			std::vector<Transform2D> m_local;
+			std::vector<Transform2D> m_world;
+
+			// slots [m_levelStart[d], m_levelStart[d + 1]) are at depth d
+			std::vector<uint32_t> m_levelStart;
+
+			// entity index to slot
+			std::vector<uint32_t> m_slotOf;
+
+			bool m_dirty = false;
+
+			uint32_t& SlotOf(Entity entity);
+			uint32_t FindSlot(Entity entity) const;
+			void RebuildOrder();
+			void PropagateLevel(uint32_t begin, uint32_t end);
+
+		public:
+			// parent has to already be in the hierarchy, NoParent makes it a root
+			void Add(Entity entity, Entity parent = NoParent, const Transform2D& local = {});
+			// the entity's children become roots and keep their current world transform
+			void Remove(Entity entity);
+			// false and nothing changes if parent is not in the hierarchy or is entity or one of its descendants
+			bool SetParent(Entity entity, Entity parent);
+
+			bool Contains(Entity entity) const;
+			Entity GetParent(Entity entity) const;
+
+			Transform2D& GetLocal(Entity entity);
+			void SetLocal(Entity entity, const Transform2D& local);
+			// valid as of the last Propagate
+			const Transform2D& GetWorld(Entity entity) const;
+
+			size_t GetSize() const;
+
+			void Propagate();
+		};
+	}
+}
@@ -0,0 +1,370 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+using namespace Engine::Jobs;
+
+JobSystem* JobSystem::instance = nullptr;
+
+namespace
+{
+	constexpr size_t NotAWorker = ~size_t(0);
+	// jobs each worker can have in flight before it starts reusing slots
+	constexpr size_t JobPoolSize = 4096;
+	// tries at finding work before an idle worker goes to sleep
+	constexpr unsigned SpinCount = 64;
+
+	std::mutex s_instanceLock;
+
+	thread_local size_t t_workerIndex = NotAWorker;
+	thread_local std::unique_ptr<Job[]> t_jobPool;
+	thread_local size_t t_nextJob = 0;
+}
+
+void Counter::Add(uint32_t count)
+{
+	m_count.fetch_add(count, std::memory_order_relaxed);
+}
+
+void Counter::Done()
+{
+	std::vector<Continuation> continuations;
+	{
+		// held across the decrement so a waiter cannot destroy the counter under us
+		std::lock_guard lock{ m_lock };
+		if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			continuations.swap(m_continuations);
+	}
+	for (auto& continuation : continuations)
+		JobSystem::instance->Start(std::move(continuation.work), continuation.counter);
+}
+
+Counter::~Counter()
+{
+	std::lock_guard lock{ m_lock };
+}
+
+bool Counter::IsDone() const
+{
+	return m_count.load(std::memory_order_acquire) == 0;
+}
+
+uint32_t Counter::GetCount() const
+{
+	return m_count.load(std::memory_order_acquire);
+}
+
+void Counter::Then(std::function<void()> work, Counter* counter)
+{
+	if (counter)
+		counter->Add(1);
+	{
+		std::lock_guard lock{ m_lock };
+		if (m_count.load(std::memory_order_acquire) != 0)
+		{
+			m_continuations.push_back(Continuation{ std::move(work), counter });
+			return;
+		}
+	}
+	JobSystem::GetInstance()->Start(std::move(work), counter);
+}
+
+WorkQueue::WorkQueue() :
+	m_jobs{ std::make_unique<std::atomic<Job*>[]>(Capacity) }
+{
+}
+
+bool WorkQueue::Push(Job* job)
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+	int64_t top = m_top.load(std::memory_order_acquire);
+	if (bottom - top >= static_cast<int64_t>(Capacity))
+		return false;
+
+	m_jobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+	m_bottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* WorkQueue::Pop()
+{
+	int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+	m_bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		// empty
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = m_jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// last job, a thief may be after it too
+		if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			job = nullptr;
+		m_bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* WorkQueue::Steal()
+{
+	int64_t top = m_top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t bottom = m_bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+		return nullptr;
+
+	Job* job = m_jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+	if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return job;
+}
+
+bool WorkQueue::IsEmpty() const
+{
+	return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+}
+
+JobSystem::JobSystem(size_t workerCount)
+{
+	for (size_t i = 0; i < workerCount; ++i)
+		m_queues.push_back(std::make_unique<WorkQueue>());
+
+	t_workerIndex = 0;
+	for (size_t i = 1; i < workerCount; ++i)
+		m_threads.emplace_back(&JobSystem::WorkerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	m_quit.store(true);
+	{
+		std::lock_guard lock{ m_sleepLock };
+		m_wake.notify_all();
+	}
+	for (auto& thread : m_threads)
+		thread.join();
+	t_workerIndex = NotAWorker;
+
+	for (Job* job : m_injected)
+		delete job;
+}
+
+JobSystem* JobSystem::GetInstance()
+{
+	std::lock_guard lock{ s_instanceLock };
+	if (!instance)
+	{
+		// the calling thread is a worker as well
+		size_t workerCount = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+		instance = new JobSystem{ workerCount };
+	}
+	return instance;
+}
+
+void JobSystem::Exit()
+{
+	std::lock_guard lock{ s_instanceLock };
+	delete instance;
+	instance = nullptr;
+}
+
+size_t JobSystem::GetWorkerCount() const
+{
+	return m_queues.size();
+}
+
+void JobSystem::Run(std::function<void()> work, Counter* counter)
+{
+	if (counter)
+		counter->Add(1);
+	Start(std::move(work), counter);
+}
+
+void JobSystem::Start(std::function<void()> work, Counter* counter)
+{
+	Job* job;
+	if (t_workerIndex != NotAWorker)
+	{
+		if (!t_jobPool)
+			t_jobPool = std::make_unique<Job[]>(JobPoolSize);
+		job = &t_jobPool[t_nextJob++ & (JobPoolSize - 1)];
+		// the pool wrapped around onto a job nobody has got to yet
+		while (job->pending.load(std::memory_order_acquire))
+		{
+			if (Job* other = FindJob())
+				Execute(other);
+			else
+				std::this_thread::yield();
+		}
+	}
+	else
+	{
+		job = new Job{};
+		job->fromHeap = true;
+	}
+
+	job->work = std::move(work);
+	job->counter = counter;
+	job->pending.store(true, std::memory_order_relaxed);
+	Schedule(job);
+}
+
+void JobSystem::Schedule(Job* job)
+{
+	if (t_workerIndex != NotAWorker)
+	{
+		if (!m_queues[t_workerIndex]->Push(job))
+		{
+			// queue is full, doing it now is as good as anything
+			Execute(job);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard lock{ m_injectLock };
+		m_injected.push_back(job);
+		m_injectedCount.fetch_add(1, std::memory_order_release);
+	}
+	WakeOne();
+}
+
+void JobSystem::WakeOne()
+{
+	m_signal.fetch_add(1, std::memory_order_seq_cst);
+	if (m_sleeping.load(std::memory_order_seq_cst))
+	{
+		// taking the lock means the sleeper is either waiting already or will see the new signal
+		std::lock_guard lock{ m_sleepLock };
+		m_wake.notify_one();
+	}
+}
+
+Job* JobSystem::FindJob()
+{
+	size_t self = t_workerIndex;
+	if (self != NotAWorker)
+	{
+		if (Job* job = m_queues[self]->Pop())
+			return job;
+	}
+
+	if (m_injectedCount.load(std::memory_order_acquire))
+	{
+		std::lock_guard lock{ m_injectLock };
+		if (!m_injected.empty())
+		{
+			Job* job = m_injected.front();
+			m_injected.pop_front();
+			m_injectedCount.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	// start with the next worker along so thieves spread out
+	size_t count = m_queues.size();
+	size_t start = self == NotAWorker ? 0 : self + 1;
+	for (size_t i = 0; i < count; ++i)
+	{
+		size_t victim = (start + i) % count;
+		if (victim == self)
+			continue;
+		if (Job* job = m_queues[victim]->Steal())
+			return job;
+	}
+	return nullptr;
+}
+
+void JobSystem::Execute(Job* job)
+{
+	// hand the slot back before running, the work may start enough jobs to wrap the pool
+	// while it waits and must not end up waiting on its own slot
+	std::function<void()> work = std::move(job->work);
+	Counter* counter = job->counter;
+	if (job->fromHeap)
+		delete job;
+	else
+	{
+		job->work = nullptr;
+		job->pending.store(false, std::memory_order_release);
+	}
+
+	work();
+
+	if (counter)
+		counter->Done();
+}
+
+void JobSystem::WorkerMain(size_t index)
+{
+	t_workerIndex = index;
+	unsigned idle = 0;
+	while (!m_quit.load(std::memory_order_relaxed))
+	{
+		if (Job* job = FindJob())
+		{
+			Execute(job);
+			idle = 0;
+			continue;
+		}
+
+		if (++idle < SpinCount)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock lock{ m_sleepLock };
+		m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+		uint64_t signal = m_signal.load(std::memory_order_seq_cst);
+		// a job pushed before the signal was read has to be picked up here
+		Job* job = FindJob();
+		if (!job)
+			m_wake.wait(lock, [&]() { return m_quit.load() || m_signal.load() != signal; });
+		m_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+		lock.unlock();
+
+		idle = 0;
+		if (job)
+			Execute(job);
+	}
+}
+
+void JobSystem::Wait(Counter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (Job* job = FindJob())
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& work)
+{
+	if (grain == 0)
+		grain = std::max<size_t>(count / (GetWorkerCount() * 4), 1);
+	if (count <= grain)
+	{
+		if (count)
+			work(0, count);
+		return;
+	}
+
+	Counter counter;
+	// the last range is left for this thread
+	size_t begin = 0;
+	for (; begin + grain < count; begin += grain)
+	{
+		size_t end = begin + grain;
+		Run([&work, begin, end]() { work(begin, end); }, &counter);
+	}
+	work(begin, count);
+	Wait(counter);
+}
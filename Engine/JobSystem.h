@@ -0,0 +1,153 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Engine
+{
+	namespace Jobs
+	{
+		class Counter;
+
+		struct Job
+		{
+			std::function<void()> work;
+			// decremented once work has run, may be null
+			Counter* counter = nullptr;
+			// cleared once the job has been picked up so its slot can be handed out again
+			std::atomic<bool> pending = false;
+			// jobs started outside the workers are not pooled
+			bool fromHeap = false;
+		};
+
+		/*
+		counts the jobs that still have to finish before something else can go ahead
+		a job is added to a counter when it is started and taken off when it is done,
+		continuations are started as soon as the count drops to zero
+		a counter has to outlive the jobs and continuations that refer to it
+		*/
+		class Counter
+		{
+			friend class JobSystem;
+
+			struct Continuation
+			{
+				std::function<void()> work;
+				Counter* counter;
+			};
+
+			std::atomic<uint32_t> m_count = 0;
+			std::mutex m_lock;
+			std::vector<Continuation> m_continuations;
+
+			void Add(uint32_t count);
+			void Done();
+
+		public:
+			Counter() = default;
+			// waits for a job that is still inside Done
+			~Counter();
+			Counter(const Counter&) = delete;
+			Counter& operator=(const Counter&) = delete;
+
+			bool IsDone() const;
+			uint32_t GetCount() const;
+
+			// runs work as a job once everything on this counter has finished,
+			// right away if nothing is outstanding, and adds it to counter if given
+			void Then(std::function<void()> work, Counter* counter = nullptr);
+		};
+
+		/*
+		bounded Chase-Lev deque, the owning thread pushes and pops at the bottom
+		while other threads steal from the top
+		*/
+		class WorkQueue
+		{
+		public:
+			static constexpr size_t Capacity = 4096;
+
+		private:
+			alignas(64) std::atomic<int64_t> m_top = 0;
+			alignas(64) std::atomic<int64_t> m_bottom = 0;
+			std::unique_ptr<std::atomic<Job*>[]> m_jobs;
+
+		public:
+			WorkQueue();
+
+			// owner only, false if the queue is full
+			bool Push(Job* job);
+			// owner only, newest job first
+			Job* Pop();
+			// any thread, oldest job first
+			Job* Steal();
+
+			bool IsEmpty() const;
+		};
+
+		/*
+		fixed pool of worker threads that take jobs from each other when they run dry
+		the thread that creates the job system is worker 0 and joins in with the work
+		whenever it waits on a counter, so a frame never stalls on a sleeping thread
+		threads that are not workers can start jobs too, they go through a shared queue
+		*/
+		class JobSystem
+		{
+			friend class Counter;
+			static JobSystem* instance;
+
+			std::vector<std::unique_ptr<WorkQueue>> m_queues;
+			std::vector<std::thread> m_threads;
+
+			// jobs started from threads that are not workers
+			std::mutex m_injectLock;
+			std::deque<Job*> m_injected;
+			std::atomic<size_t> m_injectedCount = 0;
+
+			// idle workers sleep here until a job is pushed
+			std::mutex m_sleepLock;
+			std::condition_variable m_wake;
+			std::atomic<uint32_t> m_sleeping = 0;
+			std::atomic<uint64_t> m_signal = 0;
+			std::atomic<bool> m_quit = false;
+
+			void WorkerMain(size_t index);
+			// like Run but the job has already been added to its counter
+			void Start(std::function<void()> work, Counter* counter);
+			void Schedule(Job* job);
+			void WakeOne();
+			Job* FindJob();
+			void Execute(Job* job);
+
+			JobSystem(size_t workerCount);
+			~JobSystem();
+
+		public:
+			// the first call decides which thread is worker 0
+			static JobSystem* GetInstance();
+			static void Exit();
+
+			size_t GetWorkerCount() const;
+
+			// runs work on any worker, adding it to counter if given
+			void Run(std::function<void()> work, Counter* counter = nullptr);
+
+			// runs jobs until everything on counter has finished
+			void Wait(Counter& counter);
+
+			/*
+			calls work(begin, end) over [0, count) in ranges of at most grain indices
+			and returns once all of them are done, grain 0 picks a size from the worker count
+			ranges run on the calling thread as well, small counts never leave it
+			*/
+			void ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& work);
+		};
+	}
+}
@@ -2,8 +2,14 @@
 
 Logger* Logger::instance = nullptr;
 
+namespace
+{
+	std::mutex s_instanceLock;
+}
+
 Logger* Logger::GetInstance()
 {
+	std::lock_guard lock{ s_instanceLock };
 	if (!instance)
 		instance = new Logger{};
 	return instance;
@@ -11,6 +17,7 @@ Logger* Logger::GetInstance()
 
 void Logger::Drop()
 {
+	std::lock_guard lock{ s_instanceLock };
 	delete instance;
 	instance = nullptr;
 }
@@ -25,6 +32,7 @@ Logger::Logger()
 void Logger::Log(std::string str)
 {
 #ifdef ENABLE_LOG
+	std::lock_guard lock{ m_lock };
 	fs << str;
 #else
 	(void)str;// remove warning about unused param
@@ -1,12 +1,15 @@
 #pragma once
 #include <fstream>
 #include <string>
+#include <mutex>
 
 #define ENABLE_LOG
 
 class Logger
 {
 	std::fstream fs;
+	// worlds can be built on worker threads and they log too
+	std::mutex m_lock;
 	static Logger* instance;
 public:
 	static Logger* GetInstance();
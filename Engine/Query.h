@@ -13,6 +13,9 @@ namespace Engine
   {
     namespace details
     {
+      template <typename... T>
+      constexpr bool always_false = false;
+
       template <typename T>
       concept has_Execute = requires(T & t, Engine::EntityManager::EntityManager & GM)
       {
@@ -41,30 +44,35 @@ namespace Engine
         using type = std::tuple<T_COMPONENTS...>;
       };
 
-      Bitset<2>    m_Must;
-      Bitset<2>    m_OneOf;
-      Bitset<2>    m_NoneOf;
+      Component::ComponentBitset    m_Must;
+      Component::ComponentBitset    m_OneOf;
+      Component::ComponentBitset    m_NoneOf;
 
       template<typename T>
-      void SetQueryType()
+      constexpr void SetQueryType()
       {
-        auto test = Engine::Component::component_info_v<T>;
         if constexpr (std::is_pointer_v<T>)
         {
-          m_OneOf.Set(Engine::Component::component_info_v<std::remove_pointer_t<T>>.m_UID);
+          m_OneOf.Set(Engine::Component::component_id_v<T>);
         }
         else if constexpr (std::is_reference_v<T>)
         {
-          m_Must.Set(Engine::Component::component_info_v<std::remove_reference_t<T>>.m_UID);
+          m_Must.Set(Engine::Component::component_id_v<T>);
         }
         else
         {
-          static_assert(false);
+          static_assert(details::always_false<T>, "system parameters must be references or pointers to components");
         }
       }
 
       template<typename T_Function>
-      void GenerateQueryFromFunction(T_Function&& func)
+      constexpr void GenerateQueryFromFunction(T_Function&&)
+      {
+        GenerateQueryFromType<std::decay_t<T_Function>>();
+      }
+
+      template<typename T_Function>
+      constexpr void GenerateQueryFromType()
       {
         // concept testing that it has operator()
         constexpr bool fn = details::has_Execute<T_Function>;
@@ -77,36 +85,60 @@ namespace Engine
           {
             (SetQueryType<T_Components>(), ...);
           }
-          (reinterpret_cast<func_traits::args_tuple*>(nullptr));
+          (static_cast<typename func_traits::args_tuple*>(nullptr));
         }
       }
       
       
       template<typename... T_Queries>
-      void SetFromTuple(std::tuple<T_Queries...>*)
+      constexpr void SetFromTuple(std::tuple<T_Queries...>*)
       {
         // T is a templateised type that has a variadic template pack
         auto func = [&]<template<typename ...>class T, typename ... T_Component>(T<T_Component...>*)
         {
           if constexpr (std::is_same_v<T<T_Component...>, Query::one_of<T_Component...>>)
           {
-            (m_OneOf.Set(Engine::Component::component_info_v<T_Component>.m_UID), ...);
+            (m_OneOf.Set(Engine::Component::component_id_v<T_Component>), ...);
           }
           else if constexpr (std::is_same_v<T<T_Component...>, Query::must<T_Component...>>)
           {
-            (m_Must.Set(Engine::Component::component_info_v<T_Component>.m_UID), ...);
+            (m_Must.Set(Engine::Component::component_id_v<T_Component>), ...);
           }
           else if constexpr (std::is_same_v<T<T_Component...>, Query::none_of<T_Component...>>)
           {
-            (m_NoneOf.Set(Engine::Component::component_info_v<T_Component>.m_UID), ...);
+            (m_NoneOf.Set(Engine::Component::component_id_v<T_Component>), ...);
           }
           else // fail in compilation
-            static_assert(false);
+            static_assert(details::always_false<T<T_Component...>>, "use must, one_of or none_of");
         };
-        (func(reinterpret_cast<T_Queries*>(nullptr)), ...);
+        (func(static_cast<T_Queries*>(nullptr)), ...);
+      }
+
+      // the whole query worked out at compile time
+      // e.g. Query::Make<Query::must<Position>, Query::none_of<Bullet>>()
+      template<typename... T_Queries>
+      static constexpr Query Make()
+      {
+        Query query;
+        query.SetFromTuple(static_cast<std::tuple<T_Queries...>*>(nullptr));
+        return query;
       }
 
-      bool Compare(const Bitset<2>& ArchetypeBits) const noexcept
+      // the query a functor system's operator() parameters describe
+      template<typename T_Function>
+      static constexpr Query FromFunction()
+      {
+        Query query;
+        query.GenerateQueryFromType<T_Function>();
+        return query;
+      }
+
+      constexpr bool operator==(const Query& rhs) const noexcept
+      {
+        return m_Must == rhs.m_Must && m_OneOf == rhs.m_OneOf && m_NoneOf == rhs.m_NoneOf;
+      }
+
+      constexpr bool Compare(const Component::ComponentBitset& ArchetypeBits) const noexcept
       {
         bool oneof = !(static_cast<bool>(m_OneOf)); // need to be able to convert bits to bool 
 
@@ -125,6 +157,11 @@ namespace Engine
       }
     };
 
+    // e.g. static constexpr auto& query = query_v<Query::must<Position>, Query::none_of<Bullet>>;
+    template<typename... T_Queries>
+    constexpr Query query_v = Query::Make<T_Queries...>();
+
+
 
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,180 @@
+#include "RowSorter.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace Engine::Sorting;
+
+namespace
+{
+	// spreads the 16 bits of v out to the even bits
+	uint32_t SpreadBits(uint32_t v)
+	{
+		v = (v | (v << 8)) & 0x00FF00FF;
+		v = (v | (v << 4)) & 0x0F0F0F0F;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	}
+
+	// least significant digit radix sort of rows by key, 8 bits at a time
+	void SortByKey(const std::vector<uint32_t>& keys, std::vector<Engine::Archetype::ChunkIndex>& order)
+	{
+		std::vector<Engine::Archetype::ChunkIndex> temp(order.size());
+		for (unsigned shift = 0; shift < 32; shift += 8)
+		{
+			size_t count[257] = {};
+			for (auto row : order)
+				++count[((keys[row] >> shift) & 0xFF) + 1];
+			for (size_t i = 1; i < 257; ++i)
+				count[i] += count[i - 1];
+			for (auto row : order)
+				temp[count[(keys[row] >> shift) & 0xFF]++] = row;
+			order.swap(temp);
+		}
+	}
+}
+
+uint32_t Engine::Sorting::Morton2D(uint16_t x, uint16_t y)
+{
+	return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+uint32_t Engine::Sorting::MortonKey(float x, float y, float cellSize)
+{
+	auto cell = [cellSize](float v)
+	{
+		float c = v / cellSize;
+		return static_cast<uint16_t>(std::clamp(c, 0.f, 65535.f));
+	};
+	return Morton2D(cell(x), cell(y));
+}
+
+RowSorter::RowSorter(const Tools::Query& query, KeyFunction key, size_t swapsPerUpdate, size_t resortInterval) :
+	m_query{ query },
+	m_key{ std::move(key) },
+	m_swapsPerUpdate{ swapsPerUpdate },
+	m_resortInterval{ resortInterval }
+{
+}
+
+bool RowSorter::IsSorted(const std::shared_ptr<Archetype::Archetype>& archetype) const
+{
+	for (auto& sorted : m_sorted)
+	{
+		if (sorted.archetype.lock() != archetype)
+			continue;
+		if (sorted.version != archetype->version)
+			return false;
+		// the keys may have moved on even though no row was added or removed
+		return !m_resortInterval || m_updates - sorted.sortedAt < m_resortInterval;
+	}
+	return false;
+}
+
+void RowSorter::MarkSorted(const std::shared_ptr<Archetype::Archetype>& archetype)
+{
+	// forget archetypes that no longer exist while we are here
+	m_sorted.erase(std::remove_if(m_sorted.begin(), m_sorted.end(),
+		[](auto& entry) { return entry.archetype.expired(); }), m_sorted.end());
+
+	for (auto& sorted : m_sorted)
+	{
+		if (sorted.archetype.lock() == archetype)
+		{
+			sorted.version = archetype->version;
+			sorted.sortedAt = m_updates;
+			return;
+		}
+	}
+	m_sorted.push_back({ archetype, archetype->version, m_updates });
+}
+
+void RowSorter::Prepare(Archetype::Archetype& archetype)
+{
+	size_t n = archetype.entityNum;
+	m_keys.resize(n);
+	m_key(archetype, m_keys);
+
+	m_order.resize(n);
+	std::iota(m_order.begin(), m_order.end(), 0);
+	// rechecked archetypes are often still in order, which needs no sorting and no swaps
+	if (!std::is_sorted(m_keys.begin(), m_keys.end()))
+		SortByKey(m_keys, m_order);
+
+	m_at.resize(n);
+	m_where.resize(n);
+	std::iota(m_at.begin(), m_at.end(), 0);
+	std::iota(m_where.begin(), m_where.end(), 0);
+
+	m_version = archetype.version;
+	m_cursor = 0;
+}
+
+bool RowSorter::BeginPass(EntityManager::EntityManager& world)
+{
+	auto found = world.Search(m_query);
+	auto& archetypes = found.GetStore();
+	// look at each archetype at most once per Update
+	for (size_t tried = 0; tried < archetypes.size(); ++tried)
+	{
+		auto& archetype = archetypes[(m_next + tried) % archetypes.size()];
+		if (archetype->entityNum < 2 || IsSorted(archetype))
+			continue;
+
+		m_next = (m_next + tried + 1) % archetypes.size();
+		m_current = archetype;
+		Prepare(*archetype);
+		return true;
+	}
+	return false;
+}
+
+void RowSorter::Update(EntityManager::EntityManager& world)
+{
+	++m_updates;
+	size_t budget = m_swapsPerUpdate;
+	bool began = false;
+	while (budget)
+	{
+		auto archetype = m_current.lock();
+		if (!archetype)
+		{
+			// one new pass per Update keeps an all sorted world from spinning here
+			if (began || !BeginPass(world))
+				return;
+			began = true;
+			archetype = m_current.lock();
+		}
+		else if (archetype->version != m_version)
+		{
+			// rows were added or removed since the order was worked out
+			Prepare(*archetype);
+		}
+
+		size_t n = m_order.size();
+		while (m_cursor < n && budget)
+		{
+			auto original = m_order[m_cursor];
+			auto row = m_where[original];
+			if (row != m_cursor)
+			{
+				world.SwapRows(*archetype, static_cast<Archetype::ChunkIndex>(m_cursor), row);
+				auto displaced = m_at[m_cursor];
+				m_at[m_cursor] = original;
+				m_at[row] = displaced;
+				m_where[original] = static_cast<Archetype::ChunkIndex>(m_cursor);
+				m_where[displaced] = row;
+				--budget;
+			}
+			++m_cursor;
+		}
+		// our own swaps are not a reason to start over
+		m_version = archetype->version;
+
+		if (m_cursor == n)
+		{
+			MarkSorted(archetype);
+			m_current.reset();
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "EntityManager.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Engine
+{
+	namespace Sorting
+	{
+		// interleaves the bits of x and y so cells close in 2D stay close in the 1D order
+		uint32_t Morton2D(uint16_t x, uint16_t y);
+		// morton code of the grid cell a point is in, coordinates are clamped at 0
+		uint32_t MortonKey(float x, float y, float cellSize);
+
+		/*
+		reorders the rows of every archetype matching a query by a key, across all columns
+		the new order is worked out in one go at the start of a pass, the rows are then moved
+		into place a limited number of swaps per Update so the cost is spread over several frames
+		if the archetype changes in the middle of a pass the pass starts over,
+		archetypes that were fully sorted are skipped until they change again or resortInterval
+		Updates have gone by, whichever is first, as the keys usually come from components
+		like positions that change every tick without the archetype's version moving
+		*/
+		class RowSorter
+		{
+		public:
+			// fills keys with one key per row of the archetype, rows are sorted by ascending key
+			using KeyFunction = std::function<void(Archetype::Archetype& archetype, std::vector<uint32_t>& keys)>;
+
+		private:
+			Tools::Query m_query;
+			KeyFunction m_key;
+			size_t m_swapsPerUpdate;
+			size_t m_resortInterval;
+			// Updates so far, sorted archetypes are timed against it
+			uint64_t m_updates = 0;
+
+			// the pass in progress
+			std::weak_ptr<Archetype::Archetype> m_current;
+			uint64_t m_version = 0;
+			size_t m_cursor = 0;
+			// original row that ends up at each row
+			std::vector<Archetype::ChunkIndex> m_order;
+			// original row currently at each row, and the reverse
+			std::vector<Archetype::ChunkIndex> m_at;
+			std::vector<Archetype::ChunkIndex> m_where;
+			std::vector<uint32_t> m_keys;
+
+			struct SortedArchetype
+			{
+				std::weak_ptr<Archetype::Archetype> archetype;
+				uint64_t version = 0;
+				// m_updates when the pass finished
+				uint64_t sortedAt = 0;
+			};
+			// archetypes left sorted by the last pass
+			std::vector<SortedArchetype> m_sorted;
+			// archetype the next pass starts looking from
+			size_t m_next = 0;
+
+			bool IsSorted(const std::shared_ptr<Archetype::Archetype>& archetype) const;
+			void MarkSorted(const std::shared_ptr<Archetype::Archetype>& archetype);
+			bool BeginPass(EntityManager::EntityManager& world);
+			void Prepare(Archetype::Archetype& archetype);
+
+		public:
+			// resortInterval of 0 never looks at a sorted archetype again until rows are added or removed
+			RowSorter(const Tools::Query& query, KeyFunction key, size_t swapsPerUpdate = 1024, size_t resortInterval = 60);
+
+			void Update(EntityManager::EntityManager& world);
+		};
+
+		// key function reading a single component of every row
+		// keyOf is called as uint32_t(const COMPONENT&)
+		template<typename COMPONENT, typename Func>
+		RowSorter::KeyFunction MakeKey(Func keyOf)
+		{
+			return [keyOf](Archetype::Archetype& archetype, std::vector<uint32_t>& keys)
+			{
+				// look the column up once instead of for every row
+				auto& column = dynamic_cast<Archetype::Archetype_Intermediate<COMPONENT>&>(archetype);
+				for (Archetype::ChunkIndex i = 0; i < keys.size(); ++i)
+					keys[i] = keyOf(column.GetComponent(i));
+			};
+		}
+	}
+}
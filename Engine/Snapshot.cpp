@@ -0,0 +1,124 @@
+#include "Snapshot.h"
+#include <cstring>
+
+using namespace Engine::Snapshot;
+
+Writer::Writer(std::ostream& stream) :
+	m_stream{ &stream }
+{
+}
+
+void Writer::Write(const void* data, size_t size)
+{
+	m_stream->write(static_cast<const char*>(data), size);
+}
+
+void Writer::WriteColumn(const void* data, size_t size)
+{
+	Write(data, size);
+}
+
+void Writer::WriteString(const std::string& str)
+{
+	Write<uint32_t>(static_cast<uint32_t>(str.size()));
+	Write(str.data(), str.size());
+}
+
+bool Writer::Good() const
+{
+	return m_stream->good();
+}
+
+Reader::Reader(const void* data, size_t size) :
+	m_current{ static_cast<const char*>(data) },
+	m_end{ static_cast<const char*>(data) + size }
+{
+}
+
+const char* Reader::Take(size_t size)
+{
+	if (m_failed || static_cast<size_t>(m_end - m_current) < size)
+	{
+		m_failed = true;
+		return nullptr;
+	}
+	const char* res = m_current;
+	m_current += size;
+	return res;
+}
+
+bool Reader::Read(void* dst, size_t size)
+{
+	const char* src = Take(size);
+	if (!src)
+	{
+		std::memset(dst, 0, size);
+		return false;
+	}
+	std::memcpy(dst, src, size);
+	return true;
+}
+
+std::string Reader::ReadString()
+{
+	uint32_t size = Read<uint32_t>();
+	const char* src = Take(size);
+	if (!src)
+		return {};
+	return std::string(src, size);
+}
+
+size_t Reader::Remaining() const
+{
+	return m_failed ? 0 : static_cast<size_t>(m_end - m_current);
+}
+
+bool Reader::Failed() const
+{
+	return m_failed;
+}
+
+MappedFile::MappedFile(const std::string& path) :
+	m_file{ CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr) }
+{
+	if (m_file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+		return;
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+		return;
+
+	m_view = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_view)
+		m_size = static_cast<size_t>(size.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+	if (m_view)
+		UnmapViewOfFile(m_view);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+}
+
+bool MappedFile::IsOpen() const
+{
+	return m_view != nullptr;
+}
+
+const char* MappedFile::GetData() const
+{
+	return m_view;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_size;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <type_traits>
+#include <Windows.h>
+
+namespace Engine
+{
+	namespace Snapshot
+	{
+		// "ESNP"
+		constexpr uint32_t Magic = 0x504E5345;
+		// bump whenever the layout written by EntityManager::SaveSnapshot changes
+		constexpr uint32_t Version = 3;
+
+		class Writer
+		{
+			std::ostream* m_stream = nullptr;
+		protected:
+			Writer() = default;
+		public:
+			explicit Writer(std::ostream& stream);
+			virtual ~Writer() = default;
+
+			virtual void Write(const void* data, size_t size);
+			// a column of raw component data, written like any other bytes here
+			// but the async snapshot freezes the memory instead of copying it
+			virtual void WriteColumn(const void* data, size_t size);
+
+			template<typename T>
+			void Write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be written raw");
+				Write(&value, sizeof(T));
+			}
+
+			void WriteString(const std::string& str);
+
+			virtual bool Good() const;
+		};
+
+		/*
+		reads back what a Writer wrote straight out of memory (usually a MappedFile)
+		running past the end marks the reader as failed instead of throwing,
+		reads after that return zeroed values so callers can check Failed() once at the end
+		*/
+		class Reader
+		{
+			const char* m_current;
+			const char* m_end;
+			bool m_failed = false;
+		public:
+			Reader(const void* data, size_t size);
+
+			// pointer to the next size bytes, skipping past them
+			// nullptr if there are not that many left
+			const char* Take(size_t size);
+
+			bool Read(void* dst, size_t size);
+
+			template<typename T>
+			T Read()
+			{
+				static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be read raw");
+				T value{};
+				Read(&value, sizeof(T));
+				return value;
+			}
+
+			std::string ReadString();
+
+			// bytes not read yet, for checking a count against the data before acting on it
+			size_t Remaining() const;
+
+			bool Failed() const;
+		};
+
+		// read only view of a whole file
+		class MappedFile
+		{
+			HANDLE m_file;
+			HANDLE m_mapping = nullptr;
+			const char* m_view = nullptr;
+			size_t m_size = 0;
+		public:
+			explicit MappedFile(const std::string& path);
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			bool IsOpen() const;
+			const char* GetData() const;
+			size_t GetSize() const;
+		};
+
+		// components that are not trivially copyable have to provide these to be saved
+		// void Serialize(Engine::Snapshot::Writer&) const;
+		// void Deserialize(Engine::Snapshot::Reader&);
+		template <typename T>
+		concept has_snapshot_hooks = requires(const T & constValue, T & value, Writer & writer, Reader & reader)
+		{
+			constValue.Serialize(writer);
+			value.Deserialize(reader);
+		};
+
+		template <typename T>
+		concept is_serializable = std::is_trivially_copyable_v<T> || has_snapshot_hooks<T>;
+
+		template <typename T>
+		void WriteValue(Writer& writer, const T& value)
+		{
+			if constexpr (has_snapshot_hooks<T>)
+				value.Serialize(writer);
+			else
+				writer.Write(value);
+		}
+
+		template <typename T>
+		void ReadValue(Reader& reader, T& value)
+		{
+			if constexpr (has_snapshot_hooks<T>)
+				value.Deserialize(reader);
+			else
+				reader.Read(&value, sizeof(T));
+		}
+	}
+}
@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <tuple>
+#include <utility>
+#include <type_traits>
 
 #include "EntityManager.h"
 #include "Bitset.h"
@@ -16,6 +19,9 @@ namespace Engine
     {
       void Execute(EntityManager::EntityManager&) {};
     };
+
+    // placed in a pipeline to stop the systems on either side from being fused
+    struct PipelineBarrier {};
     namespace details
     {
 
@@ -29,13 +35,11 @@ namespace Engine
       struct CompletedSystem final :  SystemBase
       {
         using func_traits = Engine::traits<user_system>;
-        Tools::Query m_Query;
+        // worked out from operator()'s parameters when the system is compiled
+        static constexpr Tools::Query m_Query = Tools::Query::FromFunction<user_system>();
         user_system us;
         
-        CompletedSystem()
-        {
-          m_Query.GenerateQueryFromFunction(us);
-        }
+        CompletedSystem() = default;
 
         // no copy constructor
         CompletedSystem(const CompletedSystem&) = delete;
@@ -63,6 +67,107 @@ namespace Engine
         }
       };
 
+      template <typename T>
+      constexpr bool is_functor_system = !has_Execute<T> && !std::is_same_v<T, PipelineBarrier>;
+
+      // systems that keep state across rows opt out of fusion with
+      // static constexpr bool isFusable = false;
+      template <typename T>
+      concept is_fusable = !requires { T::isFusable; } || T::isFusable;
+
+      // adjacent systems are fused when both are fusable functor systems over the same query
+      // the fused loop still calls them in order for each row, which only gives the same result
+      // when each call depends on nothing but its own row, a sum, count or list one system builds
+      // up for the next would be read half built
+      template <typename A, typename B>
+      constexpr bool can_fuse = [] {
+        if constexpr (is_functor_system<A> && is_functor_system<B> && is_fusable<A> && is_fusable<B>)
+          return Tools::Query::FromFunction<A>() == Tools::Query::FromFunction<B>();
+        else
+          return false;
+      }();
+
+      // indices of the systems run as one pass
+      template <size_t... I>
+      struct FusedGroup {};
+
+      // splits the pipeline into groups at compile time, DONE holds the finished groups
+      template <typename SYSTEMS, typename DONE, typename CURRENT, size_t... REST>
+      struct SplitPipeline;
+
+      template <typename SYSTEMS, typename... DONE, size_t... CURRENT>
+      struct SplitPipeline<SYSTEMS, std::tuple<DONE...>, FusedGroup<CURRENT...>>
+      {
+        using type = std::tuple<DONE..., FusedGroup<CURRENT...>>;
+      };
+
+      template <typename SYSTEMS, typename... DONE, size_t... CURRENT, size_t NEXT, size_t... REST>
+      struct SplitPipeline<SYSTEMS, std::tuple<DONE...>, FusedGroup<CURRENT...>, NEXT, REST...>
+      {
+        static constexpr size_t last = (CURRENT, ...);
+        static constexpr bool fuse = can_fuse<std::tuple_element_t<last, SYSTEMS>, std::tuple_element_t<NEXT, SYSTEMS>>;
+
+        // only the branch taken is instantiated
+        using type = typename std::conditional_t<fuse,
+          SplitPipeline<SYSTEMS, std::tuple<DONE...>, FusedGroup<CURRENT..., NEXT>, REST...>,
+          SplitPipeline<SYSTEMS, std::tuple<DONE..., FusedGroup<CURRENT...>>, FusedGroup<NEXT>, REST...>>::type;
+      };
+
+      template <typename SYSTEMS, typename INDICES>
+      struct PipelineGroups;
+
+      template <typename SYSTEMS, size_t FIRST, size_t... REST>
+      struct PipelineGroups<SYSTEMS, std::index_sequence<FIRST, REST...>>
+      {
+        using type = typename SplitPipeline<SYSTEMS, std::tuple<>, FusedGroup<FIRST>, REST...>::type;
+      };
+
+      /*
+      runs a fixed list of systems as one registered system
+      the grouping is worked out at compile time and every call is direct,
+      so there is no function pointer per system and the fused loops can be inlined
+      */
+      template <typename... user_systems>
+      struct PipelineSystem final : SystemBase
+      {
+        using systems_tuple = std::tuple<user_systems...>;
+        using groups = typename PipelineGroups<systems_tuple, std::index_sequence_for<user_systems...>>::type;
+
+        systems_tuple systems;
+
+        PipelineSystem() = default;
+        PipelineSystem(const PipelineSystem&) = delete;
+
+        template <size_t FIRST, size_t... REST>
+        void RunGroup(EntityManager::EntityManager& GM, FusedGroup<FIRST, REST...>)
+        {
+          using first_system = std::tuple_element_t<FIRST, systems_tuple>;
+          if constexpr (std::is_same_v<first_system, PipelineBarrier>)
+            return;
+          else if constexpr (has_Execute<first_system>)
+          {
+            std::get<FIRST>(systems).Execute(GM);
+            GM.UpdateStructuralComponents();
+          }
+          else
+          {
+            static constexpr Tools::Query query = Tools::Query::FromFunction<first_system>();
+            auto archetypes = GM.Search(query);
+            for (auto& archetype : archetypes.GetStore())
+              archetype->RunWithFunctors(std::get<FIRST>(systems), std::get<REST>(systems)...);
+            GM.UpdateStructuralComponents();
+          }
+        }
+
+        void Run(EntityManager::EntityManager& GM) noexcept
+        {
+          [&]<typename... GROUPS>(std::tuple<GROUPS...>*)
+          {
+            (RunGroup(GM, GROUPS{}), ...);
+          }(static_cast<groups*>(nullptr));
+        }
+      };
+
       struct SystemManager
       {
       private:
@@ -90,6 +195,26 @@ namespace Engine
                 });
         }
 
+        // registers the systems as one pipeline that runs them in order,
+        // neighbouring functor systems with the same query share a single pass over their archetypes
+        // so row n of the second system runs before row n + 1 of the first, which is only safe for
+        // functors that look at nothing but their own row, a system whose state carries over from
+        // row to row or that the next system reads has to declare isFusable = false,
+        // or put a PipelineBarrier between two systems to keep them in separate passes
+        template<typename... T_SYSTEMS>
+        void RegisterPipeline()
+        {
+          static_assert(sizeof...(T_SYSTEMS) > 0, "pipeline needs at least one system");
+          m_Systems.push_back(
+            info{
+                std::make_unique< details::PipelineSystem<T_SYSTEMS...> >(),
+                [](SystemBase& system, EntityManager::EntityManager& GM)
+                {
+                  static_cast<details::PipelineSystem<T_SYSTEMS...>&>(system).Run(GM);
+                }
+                });
+        }
+
         void Run(EntityManager::EntityManager& GameMgr)
         {
           for (const auto& S : m_Systems)
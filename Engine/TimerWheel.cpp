@@ -0,0 +1,185 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+using namespace Engine::Time;
+
+TimerWheel::TimerWheel()
+{
+	for (auto& level : m_slots)
+		level.fill(NoTimer);
+}
+
+uint32_t& TimerWheel::Head(uint16_t level, uint16_t slot)
+{
+	return level == Overflow ? m_overflow : m_slots[level][slot];
+}
+
+void TimerWheel::Link(uint32_t index)
+{
+	auto& timer = m_timers[index];
+	timer.level = Overflow;
+	timer.slot = 0;
+	// the lowest level whose span still contains the deadline,
+	// i.e. the deadline and the current tick only differ in that level's bits
+	for (uint16_t level = 0; level < LevelCount; ++level)
+	{
+		unsigned shift = SlotBits * (level + 1);
+		if ((timer.deadline >> shift) == (m_tick >> shift))
+		{
+			timer.level = level;
+			timer.slot = static_cast<uint16_t>((timer.deadline >> (SlotBits * level)) & (SlotCount - 1));
+			break;
+		}
+	}
+
+	uint32_t& head = Head(timer.level, timer.slot);
+	timer.prev = NoTimer;
+	timer.next = head;
+	if (head != NoTimer)
+		m_timers[head].prev = index;
+	head = index;
+}
+
+void TimerWheel::Unlink(uint32_t index)
+{
+	auto& timer = m_timers[index];
+	if (timer.prev != NoTimer)
+		m_timers[timer.prev].next = timer.next;
+	else
+		Head(timer.level, timer.slot) = timer.next;
+	if (timer.next != NoTimer)
+		m_timers[timer.next].prev = timer.prev;
+}
+
+void TimerWheel::Release(uint32_t index)
+{
+	auto& timer = m_timers[index];
+	timer.active = false;
+	// old handles stop matching, skipping 0 so it stays invalid
+	if (++timer.generation == 0)
+		timer.generation = 1;
+	timer.next = m_free;
+	m_free = index;
+	--m_count;
+}
+
+TimerHandle TimerWheel::Schedule(Entity entity, TimerChannel channel, uint64_t delay)
+{
+	uint32_t index;
+	if (m_free != NoTimer)
+	{
+		index = m_free;
+		m_free = m_timers[index].next;
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_timers.size());
+		m_timers.emplace_back();
+	}
+
+	auto& timer = m_timers[index];
+	timer.entity = entity;
+	timer.channel = channel;
+	timer.deadline = m_tick + std::max<uint64_t>(delay, 1);
+	timer.active = true;
+	Link(index);
+	++m_count;
+	return TimerHandle{ index, timer.generation };
+}
+
+bool TimerWheel::IsPending(TimerHandle handle) const
+{
+	return handle.index < m_timers.size() &&
+		m_timers[handle.index].active &&
+		m_timers[handle.index].generation == handle.generation;
+}
+
+bool TimerWheel::Cancel(TimerHandle handle)
+{
+	if (!IsPending(handle))
+		return false;
+	Unlink(handle.index);
+	Release(handle.index);
+	return true;
+}
+
+uint64_t TimerWheel::GetRemaining(TimerHandle handle) const
+{
+	return IsPending(handle) ? m_timers[handle.index].deadline - m_tick : 0;
+}
+
+void TimerWheel::Cascade(uint16_t level, uint16_t slot)
+{
+	uint32_t index = Head(level, slot);
+	Head(level, slot) = NoTimer;
+	while (index != NoTimer)
+	{
+		uint32_t next = m_timers[index].next;
+		Link(index);
+		index = next;
+	}
+}
+
+void TimerWheel::Advance()
+{
+	for (auto& fired : m_fired)
+		fired.clear();
+
+	++m_tick;
+
+	// highest level first, what comes down from it may have to go down further
+	if ((m_tick & ((uint64_t(1) << (SlotBits * LevelCount)) - 1)) == 0)
+		Cascade(Overflow, 0);
+	for (uint16_t level = LevelCount - 1; level > 0; --level)
+	{
+		if ((m_tick & ((uint64_t(1) << (SlotBits * level)) - 1)) == 0)
+			Cascade(level, static_cast<uint16_t>((m_tick >> (SlotBits * level)) & (SlotCount - 1)));
+	}
+
+	// everything in the current level 0 slot is due this tick
+	uint16_t slot = static_cast<uint16_t>(m_tick & (SlotCount - 1));
+	uint32_t index = m_slots[0][slot];
+	m_slots[0][slot] = NoTimer;
+	while (index != NoTimer)
+	{
+		auto& timer = m_timers[index];
+		uint32_t next = timer.next;
+		if (timer.channel >= m_fired.size())
+			m_fired.resize(timer.channel + 1);
+		m_fired[timer.channel].push_back(timer.entity);
+		Release(index);
+		index = next;
+	}
+}
+
+std::span<const Entity> TimerWheel::GetFired(TimerChannel channel) const
+{
+	if (channel >= m_fired.size())
+		return {};
+	return m_fired[channel];
+}
+
+void TimerWheel::Clear()
+{
+	// released one by one so handles from before the clear stay invalid
+	for (uint32_t i = 0; i < m_timers.size(); ++i)
+	{
+		if (m_timers[i].active)
+			Release(i);
+	}
+	for (auto& level : m_slots)
+		level.fill(NoTimer);
+	m_overflow = NoTimer;
+	for (auto& fired : m_fired)
+		fired.clear();
+}
+
+uint64_t TimerWheel::GetTick() const
+{
+	return m_tick;
+}
+
+size_t TimerWheel::GetCount() const
+{
+	return m_count;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "Entity.h"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Engine
+{
+	namespace Time
+	{
+		// lets several systems share the wheel, each only looks at its own fired batch
+		using TimerChannel = uint32_t;
+
+		struct TimerHandle
+		{
+			uint32_t index = 0;
+			// 0 is never handed out so a default handle is never pending
+			uint32_t generation = 0;
+		};
+
+		/*
+		hierarchical timing wheel counting in simulation ticks
+		each level has 256 slots, level 0 holds timers due in the current 256 ticks,
+		level 1 the current 65536 and so on, timers further out than all levels wait in an overflow list
+		when the low bits of the tick roll over, the matching slot of the level above is
+		emptied into the levels below, so every timer moves at most once per level
+		scheduling, cancelling and firing are all constant time,
+		a tick only costs as much as the timers that fire or cascade on it
+		*/
+		class TimerWheel
+		{
+		public:
+			static constexpr unsigned SlotBits = 8;
+			static constexpr size_t SlotCount = size_t(1) << SlotBits;
+			static constexpr unsigned LevelCount = 4;
+
+		private:
+			static constexpr uint32_t NoTimer = ~uint32_t(0);
+			// level used for the overflow list
+			static constexpr uint16_t Overflow = LevelCount;
+
+			struct Timer
+			{
+				Entity entity = 0;
+				uint64_t deadline = 0;
+				TimerChannel channel = 0;
+				uint32_t generation = 1;
+				// intrusive list of the slot the timer is in, or the free list
+				uint32_t prev = NoTimer;
+				uint32_t next = NoTimer;
+				uint16_t level = 0;
+				uint16_t slot = 0;
+				bool active = false;
+			};
+
+			std::vector<Timer> m_timers;
+			uint32_t m_free = NoTimer;
+			std::array<std::array<uint32_t, SlotCount>, LevelCount> m_slots;
+			uint32_t m_overflow = NoTimer;
+
+			uint64_t m_tick = 0;
+			size_t m_count = 0;
+			// indexed by channel, cleared at the start of every Advance
+			std::vector<std::vector<Entity>> m_fired;
+
+			uint32_t& Head(uint16_t level, uint16_t slot);
+			// puts a timer into the slot its deadline belongs to from the current tick
+			void Link(uint32_t index);
+			void Unlink(uint32_t index);
+			void Release(uint32_t index);
+			// reinserts every timer of a slot, they land on lower levels
+			void Cascade(uint16_t level, uint16_t slot);
+
+		public:
+			TimerWheel();
+
+			// fires entity on channel during the Advance delay ticks from now, at least the next one
+			TimerHandle Schedule(Entity entity, TimerChannel channel, uint64_t delay);
+			// false if the timer already fired or was cancelled
+			bool Cancel(TimerHandle handle);
+			bool IsPending(TimerHandle handle) const;
+			// ticks left until the timer fires, 0 if it is not pending
+			uint64_t GetRemaining(TimerHandle handle) const;
+
+			// moves on one tick and collects the timers that are due
+			void Advance();
+
+			// entities whose timers fired on channel during the last Advance
+			std::span<const Entity> GetFired(TimerChannel channel) const;
+
+			// drops fired entities keep returns false for, called as bool(Entity)
+			template<typename Func>
+			void FilterFired(Func keep)
+			{
+				for (auto& fired : m_fired)
+					std::erase_if(fired, [&](Entity entity) { return !keep(entity); });
+			}
+
+			// calls func(entity, channel, ticks left) for every pending timer
+			template<typename Func>
+			void ForEach(Func func) const
+			{
+				for (auto& timer : m_timers)
+				{
+					if (timer.active)
+						func(timer.entity, timer.channel, timer.deadline - m_tick);
+				}
+			}
+
+			// cancels every timer and forgets what fired, the tick keeps counting
+			void Clear();
+
+			uint64_t GetTick() const;
+			size_t GetCount() const;
+		};
+	}
+}
@@ -0,0 +1,58 @@
+#include "WorldStreamer.h"
+#include "Logger.h"
+#include <chrono>
+
+using namespace Engine::Streaming;
+
+WorldStreamer::~WorldStreamer()
+{
+	// the builds reference nothing of ours but should not outlive the engine
+	for (auto& pending : m_pending)
+		pending.world.wait();
+}
+
+void WorldStreamer::Load(BuildFunction build, MergedFunction onMerged)
+{
+	auto world = std::async(std::launch::async, [build = std::move(build)]()
+		{
+			auto world = std::make_unique<EntityManager::EntityManager>();
+			build(*world);
+			// deletions made while building should not be carried over
+			world->UpdateStructuralComponents();
+			return world;
+		});
+	m_pending.push_back(PendingWorld{ std::move(world), std::move(onMerged) });
+}
+
+void WorldStreamer::LoadSnapshot(const std::string& path, MergedFunction onMerged)
+{
+	Load([path](EntityManager::EntityManager& world)
+		{
+			if (!world.LoadSnapshot(path))
+				Logger::GetInstance()->Log("Failed to stream in world: " + path + "\n");
+		}, std::move(onMerged));
+}
+
+size_t WorldStreamer::Update(EntityManager::EntityManager& world, size_t maxMerges)
+{
+	size_t merged = 0;
+	// in the order they were requested, a later world never overtakes an earlier one
+	while (merged < maxMerges && !m_pending.empty() &&
+		m_pending.front().world.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		auto pending = std::move(m_pending.front());
+		m_pending.erase(m_pending.begin());
+
+		auto built = pending.world.get();
+		EntityRemap remap = world.Merge(*built);
+		if (pending.onMerged)
+			pending.onMerged(remap);
+		++merged;
+	}
+	return merged;
+}
+
+size_t WorldStreamer::GetPendingCount() const
+{
+	return m_pending.size();
+}
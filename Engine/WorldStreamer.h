@@ -0,0 +1,48 @@
+#pragma once
+#include "EntityManager.h"
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+	namespace Streaming
+	{
+		/*
+		builds worlds on worker threads and splices them into the live world
+		the build function gets a fresh EntityManager of its own, so it can call
+		AddEntity or LoadSnapshot as much as it likes without touching the live world
+		finished worlds are merged from Update on the main thread,
+		which costs one column copy per archetype instead of one AddEntity per entity
+		*/
+		class WorldStreamer
+		{
+		public:
+			using BuildFunction = std::function<void(EntityManager::EntityManager& world)>;
+			// called on the main thread after the merge, with the handles the entities ended up with
+			using MergedFunction = std::function<void(const EntityRemap& remap)>;
+
+		private:
+			struct PendingWorld
+			{
+				std::future<std::unique_ptr<EntityManager::EntityManager>> world;
+				MergedFunction onMerged;
+			};
+			std::vector<PendingWorld> m_pending;
+
+		public:
+			~WorldStreamer();
+
+			void Load(BuildFunction build, MergedFunction onMerged = {});
+			// loads a snapshot written by EntityManager::SaveSnapshot
+			void LoadSnapshot(const std::string& path, MergedFunction onMerged = {});
+
+			// merges at most maxMerges finished worlds into world, returns how many were merged
+			size_t Update(EntityManager::EntityManager& world, size_t maxMerges = 1);
+
+			size_t GetPendingCount() const;
+		};
+	}
+}
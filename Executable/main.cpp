@@ -25,6 +25,8 @@ struct D
 	int a[200];
 };
 
+ENGINE_COMPONENTS(A, B, C, D);
+
 struct Sys1
 {
 	int count = 0;
@@ -80,11 +82,6 @@ int main(int argc, char* argv[])
 	Engine::EngineManager engineMan;
 
 
-	engineMan.RegisterComponent<A>();
-	engineMan.RegisterComponent<B>();
-	engineMan.RegisterComponent<C>();
-	engineMan.RegisterComponent<D>();
-
 	engineMan.RegisterSystem<Sys1>();
 	engineMan.RegisterSystem<Sys2>();
 	engineMan.RegisterSystem<Sys3>();
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 color;
+layout (location = 2) in vec2 aTexCoord;
+// per instance, a mat4 takes locations 3 to 6
+layout (location = 3) in mat4 iTransform;
+layout (location = 7) in vec4 iColor;
+
+// uploaded once a frame by the renderer
+layout (std140) uniform FrameData
+{
+  mat4 worldTrans;
+};
+
+out vec4 vertexColor;
+
+void main(void) {
+  gl_Position = worldTrans * iTransform * vec4(position, 1.0);
+  vertexColor = iColor;
+}
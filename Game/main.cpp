@@ -5,17 +5,34 @@
 #include "EngineManager.h"
 #include "Graphics/OpenGL/GraphicSystem.h"
 #include "Graphics/OpenGL/Sprite/Sprite.h"
+#include "Graphics/OpenGL/RenderThread.h"
 
-// using fixed dt
-// will probably use real dt when i have time to deal with that
-float dt = 0.016f;
+// the simulation runs on a fixed timestep, the frame pacer
+// runs as many ticks of this length as real time calls for
+constexpr float dt = 1.f / 60.f;
 constexpr float shipIdle = 0.125;
+constexpr float shipReload = 10;
 constexpr float bulletLife = 10;
 constexpr float bulletSpeed = 30;
 constexpr float shipSpeed = 20;
 constexpr float shipShootRange = 100;
+constexpr float escortRadius = 16;
+// radians per second
+constexpr float escortSpin = 3;
 
 
+constexpr uint64_t ToTicks(float seconds)
+{
+	return static_cast<uint64_t>(seconds / dt + 0.5f);
+}
+
+// each system only looks at the timers it scheduled
+enum TimerChannels : Engine::Time::TimerChannel
+{
+	ShipReloaded,
+	BulletExpired
+};
+
 std::random_device rd;  //Will be used to obtain a seed for the random number engine
 std::mt19937 gen(rd()); //Standard mersenne_twister_engine seeded with rd()
 std::uniform_real_distribution<> dis_negToPos(-1, 1);
@@ -35,61 +52,97 @@ struct Position
 
 struct Ship
 {
-	float timeIdleLeft = 0;
+	// cleared by the ShipReloaded timer
+	bool reloading = false;
 };
 
 struct Bullet
 {
-	float lifeLeft;
 	Entity owner;
+
+	void RemapEntities(const EntityRemap& remap)
+	{
+		owner = remap(owner);
+	}
+};
+
+// circles its ship, it is a child of the ship in the hierarchy which places it
+struct Escort
+{
+	Entity ship;
+
+	void RemapEntities(const EntityRemap& remap)
+	{
+		ship = remap(ship);
+	}
 };
 
+// fixes every component's bit at compile time, append new components at the end
+// so snapshots saved before keep loading
+ENGINE_COMPONENTS(Sprite, Velocity, Position, Ship, Bullet, Escort);
+
+// the engine's hierarchy, set before any ship is created
+Engine::Hierarchy::HierarchyManager* hierarchy = nullptr;
+
+Sprite DefaultSprite()
+{
+	GraphicsSystem_OpenGL* gs = GraphicsSystem_OpenGL::GetInstance();
+	return Sprite{ gs->ShaderMan.GetShader("default"), gs->m_squareMesh, 0 };
+}
+
 void CreateBullet(Engine::EntityManager::EntityManager& EM, Position& shipPos, Position& otherPos, Entity owner)
 {
-	auto ent = EM.AddEntity<Sprite, Velocity, Position, Bullet>();
+	auto ent = EM.AddEntity<Sprite, Velocity, Position, Bullet>(DefaultSprite());
 
 	auto& pos    = EM.GetComponent<Position>(ent);
 	auto& vel    = EM.GetComponent<Velocity>(ent);
-	auto& spr    = EM.GetComponent<Sprite>(ent);
 	auto& bullet = EM.GetComponent<Bullet>(ent);
 	pos = shipPos;
 	glm::vec2 dir = { otherPos.x - shipPos.x, otherPos.y - shipPos.y };
 	dir = glm::normalize(dir);;
 	vel.x = dir.x * bulletSpeed;
 	vel.y = dir.y * bulletSpeed;
-	bullet.lifeLeft = bulletLife;
 	bullet.owner = owner;
-	spr.m_mesh = GraphicsSystem_OpenGL::GetInstance()->m_squareMesh;
-	spr.m_shader = GraphicsSystem_OpenGL::GetInstance()->ShaderMan.GetShader("default");
+	EM.GetTimers().Schedule(ent, BulletExpired, ToTicks(bulletLife));
 }
 
 Entity CreateShip(Engine::EntityManager::EntityManager& EM)
 {
-	auto ent = EM.AddEntity<Position, Sprite, Ship, Velocity>();
+	auto ent = EM.AddEntity<Position, Sprite, Ship, Velocity>(DefaultSprite());
 
 	auto& pos = EM.GetComponent<Position>(ent);
 	auto& vel = EM.GetComponent<Velocity>(ent);
-	auto& spr = EM.GetComponent<Sprite>(ent);
 	auto& ship = EM.GetComponent<Ship>(ent);
 	pos.x = float(dis_pos(gen) * 1280);
 	pos.y = float(dis_pos(gen) * 720);
 	vel.x = float(dis_negToPos(gen) * shipSpeed);
 	vel.y = float(dis_negToPos(gen) * shipSpeed);
-	ship.timeIdleLeft = shipIdle;
-	spr.m_mesh = GraphicsSystem_OpenGL::GetInstance()->m_squareMesh;
-	spr.m_shader = GraphicsSystem_OpenGL::GetInstance()->ShaderMan.GetShader("default");
+	ship.reloading = true;
+	EM.GetTimers().Schedule(ent, ShipReloaded, ToTicks(shipIdle));
+
+	// the ship is the root, FollowShips keeps it where the ship is
+	hierarchy->Add(ent, Engine::Hierarchy::HierarchyManager::NoParent, { pos.x, pos.y });
+	auto escort = EM.AddEntity<Sprite, Escort>(DefaultSprite());
+	EM.GetComponent<Escort>(escort).ship = ent;
+	hierarchy->Add(escort, ent, { escortRadius, 0 });
 	
 	return ent;
 }
 
-struct UpdateMovement
+struct Integrate
 {
 	void operator()(Position& pos, Velocity& vel)
 	{
 		pos.x += vel.x * dt;
 		pos.y += vel.y * dt;
+	}
+};
 
-		// boundary check
+// same query as Integrate, the pipeline runs both in one pass
+struct BounceOffEdges
+{
+	void operator()(Position& pos, Velocity& vel)
+	{
 		if (pos.x < 0)
 			vel.x = abs(vel.x);
 		if (pos.x > 1280)
@@ -103,24 +156,15 @@ struct UpdateMovement
 
 struct ShipBehaviour
 {
-	Engine::Tools::Query shipQuery;
-	ShipBehaviour()
-	{
-		using namespace Engine::Tools;
-		shipQuery.SetFromTuple< Query::must<Position, Ship>, Query::none_of<Bullet>>(nullptr);
-	}
+	static constexpr auto& shipQuery = Engine::Tools::query_v<
+		Engine::Tools::Query::must<Position, Ship>, Engine::Tools::Query::none_of<Bullet>>;
 
 	void Execute(Engine::EntityManager::EntityManager& GM)
 	{
-		auto archetypes = GM.Search(shipQuery);
-
-		for (auto itr = archetypes.begin(); itr != archetypes.end(); ++itr)
-		{
-			Ship& ship = GM.GetComponent<Ship>(*itr);
+		for (Entity ent : GM.GetTimers().GetFired(ShipReloaded))
+			GM.GetComponent<Ship>(ent).reloading = false;
 
-			if (ship.timeIdleLeft > 0)
-				ship.timeIdleLeft -= dt;
-		}
+		auto archetypes = GM.Search(shipQuery);
 		for(auto itr = archetypes.begin(); itr != archetypes.end(); ++itr)
 		{
 			Ship& ship1 = GM.GetComponent<Ship>(*itr);
@@ -132,7 +176,7 @@ struct ShipBehaviour
 			{
 				Ship& ship2 = GM.GetComponent<Ship>(*itr2);
 				Position& pos2 = GM.GetComponent<Position>(*itr2);
-				if (ship2.timeIdleLeft <= 0)
+				if (!ship2.reloading)
 				{
 					float distx = pos1.x - pos2.x;
 					float disty = pos1.y - pos2.y;
@@ -140,10 +184,11 @@ struct ShipBehaviour
 					{
 						//create bullet
 						CreateBullet(GM, pos2, pos1, *itr2);
-						ship2.timeIdleLeft = 10;
+						ship2.reloading = true;
+						GM.GetTimers().Schedule(*itr2, ShipReloaded, ToTicks(shipReload));
 					}
 				}
-				if (ship1.timeIdleLeft <= 0)
+				if (!ship1.reloading)
 				{
 					float distx = pos1.x - pos2.x;
 					float disty = pos1.y - pos2.y;
@@ -151,7 +196,8 @@ struct ShipBehaviour
 					{
 						//create bullet
 						CreateBullet(GM, pos1, pos2, *itr);
-						ship1.timeIdleLeft = 10;
+						ship1.reloading = true;
+						GM.GetTimers().Schedule(*itr, ShipReloaded, ToTicks(shipReload));
 					}
 				}
 			}
@@ -162,18 +208,17 @@ struct ShipBehaviour
 
 struct BulletBehaviour
 {
-	Engine::Tools::Query bulletQuery;
-	Engine::Tools::Query shipQuery;
-
-	BulletBehaviour()
-	{
-		using namespace Engine::Tools;
-		bulletQuery.SetFromTuple< Query::must<Position, Bullet>, Query::none_of<Ship>>(nullptr);
-		shipQuery.SetFromTuple< Query::must<Position, Ship>, Query::none_of<Bullet>>(nullptr);
-	}
+	static constexpr auto& bulletQuery = Engine::Tools::query_v<
+		Engine::Tools::Query::must<Position, Bullet>, Engine::Tools::Query::none_of<Ship>>;
+	static constexpr auto& shipQuery = Engine::Tools::query_v<
+		Engine::Tools::Query::must<Position, Ship>, Engine::Tools::Query::none_of<Bullet>>;
 
 	void Execute(Engine::EntityManager::EntityManager& GM)
 	{
+		// dead entities are already filtered out of the batch
+		for (Entity ent : GM.GetTimers().GetFired(BulletExpired))
+			GM.DeleteEntity(ent);
+
 		auto bulletArche = GM.Search(bulletQuery);
 
 		for (auto itr = bulletArche.begin(); itr != bulletArche.end(); ++itr)
@@ -186,13 +231,6 @@ struct BulletBehaviour
 			Bullet& bul = GM.GetComponent<Bullet>(*itr);
 			Position& pos1 = GM.GetComponent<Position>(*itr);
 
-			bul.lifeLeft -= dt;
-			if (bul.lifeLeft <= 0)
-			{
-				GM.DeleteEntity(*itr);
-				continue;
-			}
-
 			auto shipArche = GM.Search(shipQuery);
 			for (auto itr2 = shipArche.begin(); itr2 != shipArche.end(); ++itr2)
 			{
@@ -220,89 +258,112 @@ struct BulletBehaviour
 	}
 };
 
-struct Render
+// moves the hierarchy roots to their ships and spins them so the escorts circle,
+// escorts whose ship is gone go with it
+struct FollowShips
 {
-	GraphicsSystem_OpenGL* gs = nullptr;
-	Engine::Tools::Query renderQuery;
+	static constexpr auto& shipQuery = Engine::Tools::query_v<
+		Engine::Tools::Query::must<Position, Ship>, Engine::Tools::Query::none_of<Bullet>>;
+	static constexpr auto& escortQuery = Engine::Tools::query_v<Engine::Tools::Query::must<Escort>>;
 
-	Render()
+	void Execute(Engine::EntityManager::EntityManager& GM)
 	{
-		using namespace Engine::Tools;
-		renderQuery.SetFromTuple< Query::must<Position>, Query::one_of<Ship, Bullet>>(nullptr);
+		auto ships = GM.Search(shipQuery);
+		for (auto itr = ships.begin(); itr != ships.end(); ++itr)
+		{
+			Position& pos = GM.GetComponent<Position>(*itr);
+			Engine::Hierarchy::Transform2D& local = hierarchy->GetLocal(*itr);
+			local.x = pos.x;
+			local.y = pos.y;
+			local.rotation += escortSpin * dt;
+		}
+
+		// deleted ships leave the hierarchy at the sync
+		auto escorts = GM.Search(escortQuery);
+		for (auto itr = escorts.begin(); itr != escorts.end(); ++itr)
+		{
+			if (!GM.IsZombie(*itr) && !hierarchy->Contains(GM.GetComponent<Escort>(*itr).ship))
+				GM.DeleteEntity(*itr);
+		}
 	}
+};
+
+// copies what has to be drawn into the frame packet, the render thread draws it
+struct ExtractSprites
+{
+	GraphicsSystem_OpenGL* gs = nullptr;
+	static constexpr auto& renderQuery = Engine::Tools::query_v<
+		Engine::Tools::Query::must<Position, Sprite>, Engine::Tools::Query::one_of<Ship, Bullet>>;
+	static constexpr auto& escortQuery = Engine::Tools::query_v<Engine::Tools::Query::must<Sprite, Escort>>;
 
 	void Execute(Engine::EntityManager::EntityManager& GM)
 	{
 		if (!gs)
 			gs = GraphicsSystem_OpenGL::GetInstance();
-		gs->UpdateBegin();
+		Engine::Rendering::FramePacket& packet = Engine::Rendering::RenderThread::GetInstance()->GetPacket();
 
 		auto archetypes = GM.Search(renderQuery);
 
-		for (auto itr = archetypes.begin(); itr != archetypes.end(); ++itr)
-		{
-			Position& pos = GM.GetComponent<Position>(*itr);
-			Sprite& spr = GM.GetComponent<Sprite>(*itr);
-			Ship* ship = GM.TryGetComponent<Ship>(*itr);
-			Bullet* bullet = GM.TryGetComponent<Bullet>(*itr);
-
-			// hack to get the sprite to stop crashing
-			spr.m_shader = GraphicsSystem_OpenGL::GetInstance()->ShaderMan.GetShader("default");
-
-			spr.SetShader();
+		// extrapolate by the time left in the pacer's accumulator
+		// so motion stays smooth when frames and ticks do not line up
+		float lerpTime = gs->GetInterpolationAlpha() * dt;
 
-			glm::mat4 trans = {};
-			for (int i = 0; i < 4; ++i)
-			{
-				trans[i][i] = 1;
-			}
-			trans[0][0] = 2.0f / 1280;
-			trans[1][1] = 2.0f / 720;
-			trans[3][0] = -1.f;
-			trans[3][1] = -1.f;
+		glm::mat4 worldTrans = {};
+		for (int i = 0; i < 4; ++i)
+		{
+			worldTrans[i][i] = 1;
+		}
+		worldTrans[0][0] = 2.0f / 1280;
+		worldTrans[1][1] = 2.0f / 720;
+		worldTrans[3][0] = -1.f;
+		worldTrans[3][1] = -1.f;
+		packet.worldTrans = worldTrans;
+
+		// every archetype group shares one sprite, so each group is one batch
+		for (auto& archetype : archetypes.GetStore())
+		{
+			packet.BeginBatch(archetype->GetSharedComponent<Sprite>());
 
-			spr.m_shader->SetMat("worldTrans", trans);
-			if (ship)
+			for (Engine::Archetype::ChunkIndex i = 0; i < archetype->entityNum; ++i)
 			{
-				trans[1][1] = trans[0][0] = 10;
-
-				trans[3][0] = pos.x;
-				trans[3][1] = pos.y;
-
-				spr.m_shader->SetMat("transform", trans);
-				if (ship->timeIdleLeft > 0)
+				Position& pos = archetype->GetComponent<Position>(i);
+				Velocity& vel = archetype->GetComponent<Velocity>(i);
+				Ship* ship = archetype->GetComponent<Ship*>(i);
+				Bullet* bullet = archetype->GetComponent<Bullet*>(i);
+
+				glm::mat4 trans = worldTrans;
+				trans[3][0] = pos.x + vel.x * lerpTime;
+				trans[3][1] = pos.y + vel.y * lerpTime;
+				if (ship)
 				{
-					spr.m_shader->SetVector4("uColor", glm::vec4(1, 0, 0, 1));
+					trans[1][1] = trans[0][0] = 10;
+					packet.Add(trans, ship->reloading ? glm::vec4(1, 0, 0, 1) : glm::vec4(0, 1, 0, 1));
 				}
-				else
+				else if (bullet)
 				{
-					spr.m_shader->SetVector4("uColor", glm::vec4(0, 1, 0, 1));
+					trans[1][1] = trans[0][0] = 5;
+					packet.Add(trans, glm::vec4(1, 1, 1, 1));
 				}
 			}
-			else if (bullet)
-			{
-				trans[1][1] = trans[0][0] = 5;
+		}
 
-				trans[3][0] = pos.x;
-				trans[3][1] = pos.y;
+		// escorts are drawn where the hierarchy put them on the last tick
+		auto escorts = GM.Search(escortQuery);
+		for (auto& archetype : escorts.GetStore())
+		{
+			packet.BeginBatch(archetype->GetSharedComponent<Sprite>());
 
-				spr.m_shader->SetMat("transform", trans);
-				spr.m_shader->SetVector4("uColor", glm::vec4(1, 1, 1, 1));
+			for (Engine::Archetype::ChunkIndex i = 0; i < archetype->entityNum; ++i)
+			{
+				const Engine::Hierarchy::Transform2D& world = hierarchy->GetWorld(archetype->GetComponent<EntityComponent>(i).entity);
+
+				glm::mat4 trans = worldTrans;
+				trans[3][0] = world.x;
+				trans[3][1] = world.y;
+				trans[1][1] = trans[0][0] = 4;
+				packet.Add(trans, glm::vec4(0, 0.5f, 1, 1));
 			}
-			spr.Draw();
 		}
-
-	}
-};
-
-struct SwapBuffer
-{
-	GraphicsSystem_OpenGL* gs = nullptr;
-	void Execute(Engine::EntityManager::EntityManager& GM)
-	{
-		if (!gs)
-			gs = GraphicsSystem_OpenGL::GetInstance();
-		gs->UpdateEnd();
 	}
 };
 
@@ -320,21 +381,33 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
 	engineMan.Init(hInstance, nCmdShow);
 	GraphicsSystem_OpenGL* gs = GraphicsSystem_OpenGL::GetInstance();
-	gs->ShaderMan.LoadShader("Resources/VertexShader.glsl", "Resources/FragmentShader.glsl", "default");
+	// sprites are drawn instanced, the shader reads transform and colour per instance
+	gs->ShaderMan.LoadShader("Resources/InstancedVertexShader.glsl", "Resources/FragmentShader.glsl", "default");
+#if defined(DEBUG) | defined(_DEBUG)
+	// edited shaders are rebuilt while the game runs
+	gs->ShaderMan.WatchShaders("Resources");
+#endif
 
-	engineMan.RegisterComponent<EntityComponent>();
-	engineMan.RegisterComponent<Sprite>();
+	// so snapshots can be loaded before a bullet has ever been fired
+	// has to list the components in the same order as AddEntity
+	engineMan.EntMan.RegisterArchetype<Sprite, Velocity, Position, Bullet>();
+	engineMan.EntMan.RegisterArchetype<Position, Sprite, Ship, Velocity>();
+	engineMan.EntMan.RegisterArchetype<Sprite, Escort>();
+	hierarchy = &engineMan.HierMan;
 
-	engineMan.RegisterComponent<Velocity>();
-	engineMan.RegisterComponent<Position>();
-	engineMan.RegisterComponent<Ship>();
-	engineMan.RegisterComponent<Bullet>();
+	engineMan.RegisterPipeline< Integrate, BounceOffEdges, ShipBehaviour, BulletBehaviour>();
+	// after the ships have moved, the hierarchy is propagated once the systems are done
+	engineMan.RegisterSystem< FollowShips>();
+	engineMan.RegisterRenderSystem< ExtractSprites>();
 
-	engineMan.RegisterSystem< UpdateMovement>();
-	engineMan.RegisterSystem< ShipBehaviour>();
-	engineMan.RegisterSystem< BulletBehaviour>();
-	engineMan.RegisterSystem< Render>();
-	engineMan.RegisterSystem< SwapBuffer>();
+	engineMan.Pacer.SetFixedTimestep(dt);
+
+	// ships and bullets that are close on screen end up close in memory,
+	// which is what the collision checks walk through
+	engineMan.AddRowSorter(Engine::Tools::query_v<Engine::Tools::Query::must<Position>>, Engine::Sorting::MakeKey<Position>([](const Position& pos)
+		{
+			return Engine::Sorting::MortonKey(pos.x, pos.y, 16.f);
+		}));
 
 	//Entity ent[30];
 
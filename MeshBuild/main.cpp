@@ -0,0 +1,184 @@
+/*
+offline mesh build step, turns a Wavefront .obj into the .emesh the engine maps at runtime
+MeshBuild input.obj output.emesh [-cache entries] [-tolerance units] [-nocache] [-nofetch]
+*/
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Graphics/OpenGL/Mesh/MeshCompiler.h"
+
+using namespace Engine::Rendering;
+
+namespace
+{
+	struct ObjCorner
+	{
+		long position = 0;
+		long texCoord = 0;
+		long normal = 0;
+	};
+
+	// obj indices start at 1 and negative ones count back from the last element read
+	bool Resolve(long index, size_t count, size_t& result)
+	{
+		if (index > 0 && size_t(index) <= count)
+			result = size_t(index) - 1;
+		else if (index < 0 && size_t(-index) <= count)
+			result = count - size_t(-index);
+		else
+			return false;
+		return true;
+	}
+
+	ObjCorner ParseCorner(const std::string& token)
+	{
+		// v, v/vt, v//vn or v/vt/vn
+		ObjCorner corner;
+		long* fields[] = { &corner.position, &corner.texCoord, &corner.normal };
+		size_t start = 0;
+		for (long* field : fields)
+		{
+			size_t end = token.find('/', start);
+			std::string value = token.substr(start, end == std::string::npos ? std::string::npos : end - start);
+			if (!value.empty())
+				*field = std::strtol(value.c_str(), nullptr, 10);
+			if (end == std::string::npos)
+				break;
+			start = end + 1;
+		}
+		return corner;
+	}
+
+	// every face corner becomes its own vertex, the compiler welds the ones that pack the same
+	bool LoadObj(const std::string& path, MeshSource& mesh)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			std::cerr << "could not open " << path << std::endl;
+			return false;
+		}
+
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> texCoords;
+		std::vector<glm::vec3> normals;
+		bool hasTexCoords = false;
+		bool hasNormals = false;
+
+		std::string line;
+		size_t lineNumber = 0;
+		while (std::getline(file, line))
+		{
+			++lineNumber;
+			std::istringstream stream(line);
+			std::string type;
+			stream >> type;
+
+			if (type == "v")
+			{
+				glm::vec3 position;
+				stream >> position.x >> position.y >> position.z;
+				positions.push_back(position);
+			}
+			else if (type == "vt")
+			{
+				glm::vec2 uv;
+				stream >> uv.x >> uv.y;
+				texCoords.push_back(uv);
+			}
+			else if (type == "vn")
+			{
+				glm::vec3 normal;
+				stream >> normal.x >> normal.y >> normal.z;
+				normals.push_back(glm::normalize(normal));
+			}
+			else if (type == "f")
+			{
+				std::vector<uint32_t> polygon;
+				std::string token;
+				while (stream >> token)
+				{
+					ObjCorner corner = ParseCorner(token);
+					size_t position, texCoord = 0, normal = 0;
+					if (!Resolve(corner.position, positions.size(), position) ||
+						(corner.texCoord && !Resolve(corner.texCoord, texCoords.size(), texCoord)) ||
+						(corner.normal && !Resolve(corner.normal, normals.size(), normal)))
+					{
+						std::cerr << path << "(" << lineNumber << "): index out of range" << std::endl;
+						return false;
+					}
+					hasTexCoords |= corner.texCoord != 0;
+					hasNormals |= corner.normal != 0;
+
+					polygon.push_back(static_cast<uint32_t>(mesh.positions.size()));
+					mesh.positions.push_back(positions[position]);
+					mesh.texCoords.push_back(corner.texCoord ? texCoords[texCoord] : glm::vec2(0.f));
+					mesh.normals.push_back(corner.normal ? normals[normal] : glm::vec3(0.f));
+				}
+
+				// polygons are fanned out from their first corner
+				for (size_t i = 2; i < polygon.size(); ++i)
+				{
+					mesh.indices.push_back(polygon[0]);
+					mesh.indices.push_back(polygon[i - 1]);
+					mesh.indices.push_back(polygon[i]);
+				}
+			}
+		}
+
+		// the compiler only gives the mesh the attributes it has
+		if (!hasTexCoords)
+			mesh.texCoords.clear();
+		if (!hasNormals)
+			mesh.normals.clear();
+		mesh.drawMode = GL_TRIANGLES;
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "usage: MeshBuild input.obj output.emesh [-cache entries] [-tolerance units] [-nocache] [-nofetch]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	MeshCompileOptions options;
+	for (int i = 3; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		if (option == "-cache" && i + 1 < argc)
+			options.cacheSize = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+		else if (option == "-tolerance" && i + 1 < argc)
+			options.positionTolerance = std::strtof(argv[++i], nullptr);
+		else if (option == "-nocache")
+			options.optimiseVertexCache = false;
+		else if (option == "-nofetch")
+			options.optimiseVertexFetch = false;
+		else
+		{
+			std::cerr << "unknown option " << option << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	MeshSource source;
+	if (!LoadObj(argv[1], source))
+		return EXIT_FAILURE;
+
+	CompiledMesh mesh = CompileMesh(source, options);
+	if (!WriteMeshFile(argv[2], mesh))
+	{
+		std::cerr << "could not write " << argv[2] << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << argv[2] << ": " << mesh.vertexCount << " vertices (" << source.positions.size() << " corners), "
+		<< mesh.indices.size() / 3 << " triangles, " << mesh.layout.GetStride() << " bytes a vertex, ACMR "
+		<< mesh.acmrBefore << " -> " << mesh.acmrAfter << std::endl;
+	return EXIT_SUCCESS;
+}